@@ -1,12 +1,20 @@
 #include "app_state.h"
 #include "managers.h"
 #include "bible_logic.h"
+#include "downloader.h"
+#include "json.h"
 #include "utils.h"
+#include "http_client.h"
+#include "lexicon.h"
+#include "work_pool.h"
+#include "prefetcher.h"
 #include "ui_renderer.h"
 #include <sstream>
 #include <algorithm>
 #include <cmath>
 #include <cstring>
+#include <chrono>
+#include <tuple>
 
 AppState::AppState() {
     g_settings.Load();
@@ -16,36 +24,18 @@ AppState::AppState() {
     targetScrollY = scrollY = g_settings.lastScrollY;
     pageIdx = g_settings.lastPageIdx;
     trans = TRANSLATIONS[transIdx].code; trans2 = TRANSLATIONS[transIdx2].code;
+    g_chapters.SetBudget((size_t)std::max(g_settings.chapterCacheMB, 1) << 20);
+    g_cache.SetCompression(g_settings.compressCache);
+    g_cache.SetQuota((uint64_t)std::max(g_settings.cacheQuotaMB, 0) << 20);
+    g_prefetch.SetBudgets((size_t)std::max(g_settings.prefetchMB, 0) << 20, g_settings.prefetchPerMinute);
+    SelectTransport(g_settings.transport, g_settings.fixtureDir, g_settings.stubLatencyMs, g_settings.stubErrorRate);
     UpdateColors(); UpdateTitle();
-    workerThread = std::thread(&AppState::WorkerLoop, this);
 }
 
 AppState::~AppState() {
-    quitWorker = true;
-    queueCondVar.notify_all();
-    if (workerThread.joinable()) workerThread.join();
-}
-
-void AppState::PushTask(std::function<void()> task, bool clearQueue) {
-    {
-        std::lock_guard<std::mutex> lock(queueMutex);
-        if (clearQueue) { std::queue<std::function<void()>> empty; std::swap(taskQueue, empty); }
-        taskQueue.push(task);
-    }
-    queueCondVar.notify_one();
-}
-
-void AppState::WorkerLoop() {
-    while (!quitWorker) {
-        std::function<void()> task;
-        {
-            std::unique_lock<std::mutex> lock(queueMutex);
-            queueCondVar.wait(lock, [this]() { return !taskQueue.empty() || quitWorker; });
-            if (quitWorker) break;
-            task = taskQueue.front(); taskQueue.pop();
-        }
-        if (task) task();
-    }
+    scheduler.Stop();
+    g_downloader.Stop(); // Must finish writing before the cache managers are torn down
+    g_lexicon.Stop();
 }
 
 void AppState::SaveSettings() {
@@ -85,109 +75,144 @@ void AppState::ToggleVerseSelection(int vNum) {
 void AppState::ClearSelection() { selectedVerses.clear(); }
 
 void AppState::CopySelection() {
-    if (selectedVerses.empty() || buf.empty() || !buf[0].isLoaded) return;
-    std::string full = buf[0].book + " (" + buf[0].translation + ")\n\n";
+    const auto& buf = view->buf;
+    if (selectedVerses.empty() || buf.empty() || !buf[0]->isLoaded) return;
+    std::string full = buf[0]->book + " (" + buf[0]->translation + ")\n\n";
     for (int vNum : selectedVerses) {
-        for (const auto& v : buf[0].verses) {
-            if (v.number == vNum) { full += std::to_string(v.number) + " " + v.text + "\n"; break; }
+        for (const auto& v : buf[0]->verses) {
+            if (v.number == vNum) { full += std::to_string(v.number) + " " + std::string(v.text) + "\n"; break; }
         }
     }
     CopyToClipboard(full);
     SetStatus("Selection copied!");
 }
 
+void AppState::Publish(std::shared_ptr<BufferSnapshot> next) {
+    std::atomic_store(&published, SnapshotRef(std::move(next)));
+    needsPageRebuild = true;
+}
+
 void AppState::InitBuffer(bool resetScroll) {
     isLoading = true;
     if (resetScroll) { targetScrollY = 0; scrollY = 0; scrollChapterIdx = 0; ClearSelection(); lastSelectedVerse = -1; isEditingNote = false; }
-    PushTask([this]() {
-        { std::lock_guard<std::mutex> lock(bufferMutex); buf.clear(); buf2.clear(); }
-        Chapter c = LoadOrFetch(curBookIdx, curChNum, trans);
-        c.bookIndex = curBookIdx; c.bookAbbrev = BIBLE_BOOKS[curBookIdx].abbrev;
+    auto started = std::chrono::steady_clock::now();
+    // A newer navigation supersedes this one, and growth of the old buffer is pointless.
+    // Only the previous navigation is cancelled: a lookup or refresh sharing the lane runs on.
+    scheduler.Cancel(TaskClass::Growth);
+    navToken.Cancel();
+    navToken = scheduler.Submit(TaskClass::Interactive, [this, started, b = curBookIdx, c = curChNum, t = trans, t2 = trans2, par = parallelMode, nav = isNavigating](const CancelToken& tok) {
         {
             std::lock_guard<std::mutex> lock(bufferMutex);
-            buf.push_back(c);
-            if (parallelMode) {
-                Chapter c2 = LoadOrFetch(curBookIdx, curChNum, trans2);
-                c2.bookIndex = curBookIdx; c2.bookAbbrev = BIBLE_BOOKS[curBookIdx].abbrev;
-                buf2.push_back(c2);
-            }
-            bufAnchorBook = curBookIdx; bufAnchorCh = curChNum;
-            needsPageRebuild = true;
+            if (tok.Cancelled()) return;
+            auto next = std::make_shared<BufferSnapshot>();
+            next->anchorBook = b; next->anchorCh = c;
+            Publish(next);
         }
-        if (c.isLoaded) {
-            int nb = curBookIdx, nc = curChNum;
-            if (NextChapter(nb, nc)) {
-                Chapter n = LoadOrFetch(nb, nc, trans); n.bookIndex = nb; n.bookAbbrev = BIBLE_BOOKS[nb].abbrev;
-                {
-                    std::lock_guard<std::mutex> lock(bufferMutex);
-                    buf.push_back(n);
-                    if (parallelMode) {
-                        Chapter n2 = LoadOrFetch(nb, nc, trans2);
-                        n2.bookIndex = nb; n2.bookAbbrev = BIBLE_BOOKS[nb].abbrev;
-                        buf2.push_back(n2);
-                    }
-                    needsPageRebuild = true;
+        // The chapter and the one after it, in both columns, requested together. Each
+        // column is published in order as soon as its next chapter is in, so the current
+        // chapter shows up without waiting for the rest.
+        int cols = par ? 2 : 1, nb = b, nc = c;
+        std::vector<ChapterRequest> reqs = {{b, c, t}};
+        if (par) reqs.push_back({b, c, t2});
+        if (NextChapter(nb, nc)) { reqs.push_back({nb, nc, t}); if (par) reqs.push_back({nb, nc, t2}); }
+        std::vector<ChapterRef> got(reqs.size());
+        size_t shown[2] = {0, 0};
+        LoadOrFetchMany(reqs, [&](size_t i, ChapterRef ch) {
+            got[i] = ch;
+            g_prefetch.Claim(reqs[i].trans, reqs[i].bookIdx, reqs[i].chNum);
+            std::lock_guard<std::mutex> lock(bufferMutex);
+            if (tok.Cancelled()) return; // Superseded: the newer task owns the buffer now
+            std::shared_ptr<BufferSnapshot> next;
+            for (int col = 0; col < cols; col++) {
+                size_t& p = shown[col];
+                while (p * cols + col < got.size() && got[p * cols + col]) {
+                    if (!next) next = std::make_shared<BufferSnapshot>(*Snapshot());
+                    (col ? next->buf2 : next->buf).push_back(got[p * cols + col]);
+                    if (col == 0 && p == 0) firstVerseMs = (int)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started).count();
+                    p++; needsLexicon = true;
                 }
             }
-            g_hist.Add(c.book, curBookIdx, curChNum, trans);
-            if (!isNavigating) PushNavPoint(curBookIdx, curChNum);
+            if (next) Publish(next);
+        });
+        if (tok.Cancelled()) return; // isLoading stays with the newer task
+        if (got[0]->isLoaded) {
+            g_hist.Add(got[0]->book, b, c, t);
+            std::lock_guard<std::mutex> lock(bufferMutex);
+            if (!nav) { postedNav = {b, c}; workerPosted = true; }
         }
+        needsPrefetch = true;
         isLoading = false;
-    }, true);
+    });
+}
+
+// Both columns of one chapter, fetched side by side in parallel mode
+std::pair<ChapterRef, ChapterRef> AppState::LoadColumns(int b, int c) {
+    std::vector<ChapterRequest> reqs = {{b, c, trans}};
+    if (parallelMode) reqs.push_back({b, c, trans2});
+    ChapterRef got[2];
+    LoadOrFetchMany(reqs, [&](size_t i, ChapterRef ch) { got[i] = ch; });
+    return {got[0], got[1]};
 }
 
 void AppState::ToggleParallelMode(Font font) {
     parallelMode = !parallelMode;
     if (parallelMode) { trans2 = TRANSLATIONS[transIdx2].code; InitBuffer(); } 
-    else { std::lock_guard<std::mutex> lock(bufferMutex); buf2.clear(); needsPageRebuild = true; }
+    else { std::lock_guard<std::mutex> lock(bufferMutex); auto next = std::make_shared<BufferSnapshot>(*Snapshot()); next->buf2.clear(); Publish(next); }
     targetScrollY = 0; scrollY = 0; SaveSettings(); UpdateTitle();
 }
 
 void AppState::GrowBottom() {
-    if (isLoading || buf.empty()) return;
-    isLoading = true;
-    PushTask([this]() {
+    if (isLoading || view->buf.empty()) return;
+    isLoading = true; readDir = 1;
+    scheduler.Submit(TaskClass::Growth, [this](const CancelToken& tok) {
         int nb, nc;
-        { std::lock_guard<std::mutex> lock(bufferMutex); const Chapter& last = buf.back(); nb = last.bookIndex; nc = last.chapter; }
+        { SnapshotRef cur = Snapshot(); if (tok.Cancelled() || cur->buf.empty()) return; const Chapter& last = *cur->buf.back(); nb = last.bookIndex; nc = last.chapter; }
         if (NextChapter(nb, nc)) {
-            Chapter ch = LoadOrFetch(nb, nc, trans); ch.bookIndex = nb; ch.bookAbbrev = BIBLE_BOOKS[nb].abbrev;
+            auto [ch, ch2] = LoadColumns(nb, nc);
+            g_prefetch.Claim(trans, nb, nc); if (ch2) g_prefetch.Claim(trans2, nb, nc);
             {
                 std::lock_guard<std::mutex> lock(bufferMutex);
-                buf.push_back(ch);
-                if (parallelMode) { Chapter ch2 = LoadOrFetch(nb, nc, trans2); ch2.bookIndex = nb; ch2.bookAbbrev = BIBLE_BOOKS[nb].abbrev; buf2.push_back(ch2); }
-                if ((int)buf.size() > BUF_MAX) { buf.pop_front(); if (parallelMode) buf2.pop_front(); NextChapter(bufAnchorBook, bufAnchorCh); }
-                needsPageRebuild = true;
+                if (tok.Cancelled()) return; // A navigation replaced the buffer meanwhile
+                auto next = std::make_shared<BufferSnapshot>(*Snapshot());
+                next->buf.push_back(ch);
+                if (ch2) next->buf2.push_back(ch2);
+                if ((int)next->buf.size() > BUF_MAX) { next->buf.pop_front(); if (parallelMode) next->buf2.pop_front(); NextChapter(next->anchorBook, next->anchorCh); }
+                Publish(next); needsLexicon = true;
             }
         }
+        needsPrefetch = true;
         isLoading = false;
     });
 }
 
 void AppState::GrowTop() {
-    if (isLoading || buf.empty()) return;
-    isLoading = true;
-    PushTask([this]() {
+    if (isLoading || view->buf.empty()) return;
+    isLoading = true; readDir = -1;
+    scheduler.Submit(TaskClass::Growth, [this](const CancelToken& tok) {
         int nb, nc;
-        { std::lock_guard<std::mutex> lock(bufferMutex); const Chapter& first = buf.front(); nb = first.bookIndex; nc = first.chapter; }
+        { SnapshotRef cur = Snapshot(); if (tok.Cancelled() || cur->buf.empty()) return; const Chapter& first = *cur->buf.front(); nb = first.bookIndex; nc = first.chapter; }
         if (PrevChapter(nb, nc)) {
-            Chapter ch = LoadOrFetch(nb, nc, trans); ch.bookIndex = nb; ch.bookAbbrev = BIBLE_BOOKS[nb].abbrev;
+            auto [ch, ch2] = LoadColumns(nb, nc);
+            g_prefetch.Claim(trans, nb, nc); if (ch2) g_prefetch.Claim(trans2, nb, nc);
             {
                 std::lock_guard<std::mutex> lock(bufferMutex);
-                buf.push_front(ch);
-                if (parallelMode) { Chapter ch2 = LoadOrFetch(nb, nc, trans2); ch2.bookIndex = nb; ch2.bookAbbrev = BIBLE_BOOKS[nb].abbrev; buf2.push_front(ch2); }
-                bufAnchorBook = nb; bufAnchorCh = nc;
-                if ((int)buf.size() > BUF_MAX) { buf.pop_back(); if (parallelMode) buf2.pop_back(); }
-                needsPageRebuild = true;
+                if (tok.Cancelled()) return; // A navigation replaced the buffer meanwhile
+                auto next = std::make_shared<BufferSnapshot>(*Snapshot());
+                next->buf.push_front(ch);
+                if (ch2) next->buf2.push_front(ch2);
+                next->anchorBook = nb; next->anchorCh = nc;
+                if ((int)next->buf.size() > BUF_MAX) { next->buf.pop_back(); if (parallelMode) next->buf2.pop_back(); }
+                Publish(next); needsLexicon = true;
             }
         }
+        needsPrefetch = true;
         isLoading = false;
     });
 }
 
 void AppState::RebuildPages(Font font) { 
-    std::lock_guard<std::mutex> lock(bufferMutex); 
-    if (buf.empty()) return;
-    pages = BuildPages(buf, buf2, parallelMode, font, 700, 500, fontSize, lineSpacing); 
+    if (view->buf.empty()) return;
+    pages = BuildPages(view->buf, view->buf2, parallelMode, font, 700, 500, fontSize, lineSpacing); 
     if (pageIdx >= (int)pages.size()) pageIdx = (int)pages.size() - 1; 
     if (pageIdx < 0) pageIdx = 0; 
     SaveSettings(); 
@@ -196,27 +221,44 @@ void AppState::RebuildPages(Font font) {
 void AppState::BookPageNext(Font font) { if (pages.empty()) return; if (pageIdx >= (int)pages.size() - 1) { if (!isLoading) GrowBottom(); } if (pageIdx < (int)pages.size() - 1) pageIdx++; }
 void AppState::BookPagePrev(Font font) { if (pages.empty()) return; if (pageIdx <= 0) { if (!isLoading) GrowTop(); } else pageIdx--; }
 
-void AppState::PrevBook() { if (curBookIdx > 0) { curBookIdx--; curChNum = 1; InitBuffer(); } }
-void AppState::NextBook() { if (curBookIdx < (int)BIBLE_BOOKS.size() - 1) { curBookIdx++; curChNum = 1; InitBuffer(); } }
+void AppState::PrevBook() { if (curBookIdx > 0) { curBookIdx--; curChNum = 1; readDir = -1; InitBuffer(); } }
+void AppState::NextBook() { if (curBookIdx < (int)BIBLE_BOOKS.size() - 1) { curBookIdx++; curChNum = 1; readDir = 1; InitBuffer(); } }
 
 void AppState::ForceRefresh(Font font) {
-    std::string p = "cache/" + trans + "/" + BIBLE_BOOKS[curBookIdx].abbrev + "/" + std::to_string(curChNum) + ".json";
-    remove(p.c_str()); InitBuffer(); SetStatus("Passage refreshed.");
+    SetStatus("Checking for changes...");
+    scheduler.Submit(TaskClass::Interactive, [this, b = curBookIdx, c = curChNum, t = trans, t2 = parallelMode ? trans2 : std::string()](const CancelToken&) {
+        int updated = 0, failed = 0;
+        for (const std::string& tr : {t, t2}) {
+            if (tr.empty()) continue;
+            ChapterRef ch;
+            Revalidation r = RevalidateChapter(b, c, tr, ch);
+            if (r == Revalidation::Failed) failed++;
+            if (r != Revalidation::Updated) continue;
+            updated++;
+            std::lock_guard<std::mutex> lock(bufferMutex); // Swap the fresh copy in wherever it is shown
+            auto next = std::make_shared<BufferSnapshot>(*Snapshot());
+            for (auto* col : {&next->buf, &next->buf2}) for (auto& e : *col) if (e->bookIndex == b && e->chapter == c && e->translation == tr) e = ch;
+            Publish(next); needsLexicon = true;
+        }
+        std::lock_guard<std::mutex> lock(bufferMutex);
+        workerStatus = failed ? "Refresh failed; showing the saved copy." : updated ? "Passage refreshed." : "Passage is up to date.";
+        workerPosted = true;
+    });
 }
 
 void AppState::CopyChapter() {
-    std::lock_guard<std::mutex> lock(bufferMutex); if (buf.empty() || !buf[0].isLoaded) return;
-    std::string fullText = buf[0].book + " (" + buf[0].translation + ")\n\n";
-    for (const auto& v : buf[0].verses) fullText += std::to_string(v.number) + " " + v.text + "\n";
+    const auto& buf = view->buf; if (buf.empty() || !buf[0]->isLoaded) return;
+    std::string fullText = buf[0]->book + " (" + buf[0]->translation + ")\n\n";
+    for (const auto& v : buf[0]->verses) fullText += std::to_string(v.number) + " " + std::string(v.text) + "\n";
     CopyToClipboard(fullText); SetStatus("Chapter copied!");
 }
 
 void AppState::UpdateTitle() {
-    std::lock_guard<std::mutex> lock(bufferMutex);
+    const auto& buf = view->buf;
     int ci = bookMode ? (pageIdx < (int)pages.size() ? pages[pageIdx].chapterBufIndex : 0) : scrollChapterIdx;
     std::string t = "Divine Word - Holy Bible " + version;
-    if (ci < (int)buf.size() && buf[ci].isLoaded) { 
-        t += " - " + buf[ci].book; 
+    if (ci < (int)buf.size() && buf[ci]->isLoaded) { 
+        t += " - " + buf[ci]->book; 
         if (parallelMode) t += " / " + trans2; else t += " (" + trans + ")"; 
     }
     SetWindowTitle(t.c_str());
@@ -232,68 +274,124 @@ void AppState::PushNavPoint(int b, int c) {
 void AppState::GoBack() { if (navIndex > 0) { navIndex--; isNavigating = true; curBookIdx = navHistory[navIndex].bookIdx; curChNum = navHistory[navIndex].chNum; InitBuffer(); isNavigating = false; } }
 void AppState::GoForward() { if (navIndex < (int)navHistory.size() - 1) { navIndex++; isNavigating = true; curBookIdx = navHistory[navIndex].bookIdx; curChNum = navHistory[navIndex].chNum; InitBuffer(); isNavigating = false; } }
 
-void AppState::PrevSequential() { int b = curBookIdx, c = curChNum; if (PrevChapter(b, c)) { curBookIdx = b; curChNum = c; InitBuffer(); } }
-void AppState::NextSequential() { int b = curBookIdx, c = curChNum; if (NextChapter(b, c)) { curBookIdx = b; curChNum = c; InitBuffer(); } }
+void AppState::PrevSequential() { int b = curBookIdx, c = curChNum; if (PrevChapter(b, c)) { curBookIdx = b; curChNum = c; readDir = -1; InitBuffer(); } }
+void AppState::NextSequential() { int b = curBookIdx, c = curChNum; if (NextChapter(b, c)) { curBookIdx = b; curChNum = c; readDir = 1; InitBuffer(); } }
 
 void AppState::StartGlobalSearch() {
-    gSearchResults.clear(); gSearchActive = true; gSearchProgress = 0;
+    gSearchResults.clear();
+    { std::lock_guard<std::mutex> lock(bufferMutex); postedSearch.clear(); } // From a search this one replaces
+    gSearchActive = true; gSearchProgress = 0;
     std::string query = ToLower(gSearchBuf); std::string currentTrans = trans;
-    PushTask([this, query, currentTrans]() {
-        for (int b = 0; b < (int)BIBLE_BOOKS.size(); b++) {
-            if (quitWorker || !gSearchActive) break;
-            std::string ba = BIBLE_BOOKS[b].abbrev;
-            for (int c = 1; c <= BIBLE_BOOKS[b].chapters; c++) {
-                if (g_cache.Has(currentTrans, ba, c)) {
-                    Chapter ch = g_cache.Load(currentTrans, ba, c);
-                    for (const auto& v : ch.verses) if (ToLower(v.text).find(query) != std::string::npos) { std::lock_guard<std::mutex> lock(bufferMutex); gSearchResults.push_back({ch.bookIndex, c, v.number, BIBLE_BOOKS[b].name, v.text}); }
-                }
-            }
-            gSearchProgress = b + 1;
-        }
+    scheduler.Submit(TaskClass::Search, [this, query, currentTrans](const CancelToken& tok) {
+        // One pool item per chapter; each thread keeps its own matches, merged in Bible order at the end
+        int books = (int)BIBLE_BOOKS.size();
+        std::vector<int> first(books + 1, 0); // Item index of each book's chapter 1
+        for (int b = 0; b < books; b++) first[b + 1] = first[b] + BIBLE_BOOKS[b].chapters;
+        std::vector<std::atomic<int>> left(books); // Chapters still to search; a book counts towards progress at zero
+        for (int b = 0; b < books; b++) left[b] = BIBLE_BOOKS[b].chapters;
+        std::vector<std::vector<GlobalSearchMatch>> found(g_workPool.Threads());
+        g_workPool.ParallelFor(first[books], [&](int item, int w) {
+            int b = (int)(std::upper_bound(first.begin(), first.end(), item) - first.begin()) - 1, c = item - first[b] + 1;
+            if (gSearchActive)
+                if (ChapterRef ch = LoadCached(b, c, currentTrans))
+                    for (const auto& v : ch->verses) if (ToLower(v.text).find(query) != std::string::npos) found[w].push_back({b, c, v.number, BIBLE_BOOKS[b].name, std::string(v.text)});
+            if (--left[b] == 0) gSearchProgress++;
+        }, &tok);
+        if (tok.Cancelled()) return; // A superseding search is active now
+        std::vector<GlobalSearchMatch> all;
+        for (auto& f : found) all.insert(all.end(), std::make_move_iterator(f.begin()), std::make_move_iterator(f.end()));
+        std::sort(all.begin(), all.end(), [](const GlobalSearchMatch& a, const GlobalSearchMatch& b) { return std::tie(a.bookIdx, a.chapter, a.verse) < std::tie(b.bookIdx, b.chapter, b.verse); });
+        std::lock_guard<std::mutex> lock(bufferMutex);
+        if (tok.Cancelled()) return;
+        postedSearch = std::move(all); workerPosted = true;
         gSearchActive = false;
-    });
+    }, true);
 }
 
 void AppState::UpdateGlobalSearch() {}
 void AppState::Update() { 
+    view = Snapshot(); // This frame's chapters; workers may publish newer ones meanwhile
     UpdateTitle(); 
+    if (workerPosted.exchange(false)) {
+        std::lock_guard<std::mutex> lock(bufferMutex);
+        if (!workerStatus.empty()) { SetStatus(workerStatus); workerStatus.clear(); }
+        if (!fetchedStrongs.number.empty()) { // Dropped if another word was opened meanwhile
+            if (fetchedStrongs.number == currentStrongs.number) currentStrongs = std::move(fetchedStrongs);
+            fetchedStrongs = StrongsDef();
+        }
+        if (!postedSearch.empty()) { gSearchResults = std::move(postedSearch); postedSearch.clear(); }
+        if (postedNav.bookIdx >= 0) { PushNavPoint(postedNav.bookIdx, postedNav.chNum); postedNav.bookIdx = -1; }
+    }
+    const auto& buf = view->buf;
+    if (studyMode && needsLexicon.exchange(false)) QueueLexicon();
+    if (!isLoading && needsPrefetch.exchange(false)) QueuePrefetch();
+    if (g_transport->Offline() != wasOffline) {
+        wasOffline = !wasOffline;
+        SetStatus(wasOffline ? "Connection lost: showing saved chapters only." : "Back online.");
+        // Offline placeholders never reach the disk cache, so any still shown get another try
+        bool placeholders = false;
+        for (auto* col : {&view->buf, &view->buf2}) for (const auto& e : *col) placeholders |= !g_cache.Has(e->translation, e->bookAbbrev, e->chapter);
+        if (!wasOffline && placeholders && !isLoading) InitBuffer(false);
+    }
     // Sync current position with visible content
-    std::lock_guard<std::mutex> lock(bufferMutex);
     int ci = bookMode ? (pageIdx < (int)pages.size() ? pages[pageIdx].chapterBufIndex : 0) : scrollChapterIdx;
-    if (ci >= 0 && ci < (int)buf.size() && buf[ci].isLoaded) {
-        curBookIdx = buf[ci].bookIndex;
-        curChNum = buf[ci].chapter;
+    if (ci >= 0 && ci < (int)buf.size() && buf[ci]->isLoaded) {
+        curBookIdx = buf[ci]->bookIndex;
+        curChNum = buf[ci]->chapter;
     }
 }
 
-void AppState::LookupStrongs(const std::string& number) {
-    if (number.empty()) return;
+void AppState::LookupStrongs(int bookIdx, uint32_t number) {
     showWordStudy = true;
-    currentStrongs.active = false;
-    currentStrongs.number = number;
+    std::string key = StrongsKey(bookIdx, number);
+    if (g_lexicon.Get(key, currentStrongs)) return; // Prefetched or looked up before: no wait
+    currentStrongs = StrongsDef();
+    currentStrongs.number = key;
     currentStrongs.definition = "Loading definition...";
-    
-    // Determine H or G based on current book
-    std::string prefix = (curBookIdx < 39) ? "H" : "G";
-    std::string query = prefix + number;
-    
-    PushTask([this, query]() {
-        std::string url = "https://bolls.life/dictionary-definition/BDBT/" + query + "/";
-        std::string resp = HttpGet(url);
-        if (resp.empty() || resp == "[]") {
-            currentStrongs.definition = "No definition found for " + query;
-            return;
-        }
-        
-        auto defs = JArr(resp, "");
-        if (!defs.empty()) {
-            std::string d = defs[0];
-            currentStrongs.lexeme = JStr(d, "lexeme");
-            currentStrongs.transliteration = JStr(d, "transliteration");
-            currentStrongs.pronunciation = JStr(d, "pronunciation");
-            currentStrongs.definition = StripTags(JStr(d, "definition"));
-            currentStrongs.shortDef = JStr(d, "short_definition");
-            currentStrongs.active = true;
-        }
+    lookupToken.Cancel();
+    lookupToken = scheduler.Submit(TaskClass::Interactive, [this, key](const CancelToken& tok) {
+        StrongsDef d;
+        LexiconStore::Result r = g_lexicon.Fetch(key, d);
+        if (r == LexiconStore::Result::NotFound) d.definition = "No definition found for " + key;
+        else if (r == LexiconStore::Result::Failed) d.definition = "Could not load the definition of " + key + ".";
+        d.number = key;
+        std::lock_guard<std::mutex> lock(bufferMutex);
+        if (!tok.Cancelled()) { fetchedStrongs = std::move(d); workerPosted = true; }
     });
-}
\ No newline at end of file
+}
+
+// Every Strong's number in the buffered chapters, for the lexicon to fetch ahead of a click
+void AppState::QueueLexicon() {
+    std::vector<std::string> keys;
+    for (auto* col : {&view->buf, &view->buf2})
+        for (const auto& ch : *col) for (const auto& v : ch->verses) for (const auto& t : v.tags) keys.push_back(StrongsKey(ch->bookIndex, t.number));
+    g_lexicon.Prefetch(keys);
+}
+
+// Likeliest next chapters first: onward in the reading direction, one step the other way,
+// the back/forward targets, today's plan and the most recent history. Newer guesses
+// replace a prefetch still running.
+void AppState::QueuePrefetch() {
+    const auto& buf = view->buf;
+    if (buf.empty()) return;
+    std::vector<std::pair<int, int>> guess;
+    const Chapter& ahead = readDir > 0 ? *buf.back() : *buf.front();
+    const Chapter& behind = readDir > 0 ? *buf.front() : *buf.back();
+    int b = ahead.bookIndex, c = ahead.chapter;
+    for (int i = 0; i < 2 && (readDir > 0 ? NextChapter(b, c) : PrevChapter(b, c)); i++) guess.push_back({b, c});
+    b = behind.bookIndex; c = behind.chapter;
+    if (readDir > 0 ? PrevChapter(b, c) : NextChapter(b, c)) guess.push_back({b, c});
+    for (int i : {navIndex - 1, navIndex + 1}) if (i >= 0 && i < (int)navHistory.size()) guess.push_back({navHistory[i].bookIdx, navHistory[i].chNum});
+    time_t now = time(nullptr);
+    for (const auto& p : GetDailyReading(localtime(&now)->tm_yday + 1)) guess.push_back(p);
+    std::vector<HistoryEntry> recent = g_hist.All();
+    for (size_t i = 0; i < recent.size() && i < 3; i++) guess.push_back({recent[i].bookIndex, recent[i].chapter});
+
+    std::vector<ChapterRequest> wanted;
+    for (const auto& [gb, gc] : guess) {
+        if (std::any_of(buf.begin(), buf.end(), [&](const ChapterRef& ch) { return ch->bookIndex == gb && ch->chapter == gc; })) continue;
+        for (const std::string& t : {trans, parallelMode ? trans2 : std::string()})
+            if (!t.empty() && std::none_of(wanted.begin(), wanted.end(), [&](const ChapterRequest& r) { return r.bookIdx == gb && r.chNum == gc && r.trans == t; })) wanted.push_back({gb, gc, t});
+    }
+    if (!wanted.empty()) scheduler.Submit(TaskClass::Prefetch, [wanted](const CancelToken& tok) { g_prefetch.Run(wanted, tok); }, true);
+}
@@ -3,6 +3,7 @@
 #define RAYBIBLE_APP_STATE_H
 
 #include "raybible.h"
+#include "task_scheduler.h"
 #include <string>
 #include <vector>
 #include <deque>
@@ -14,10 +15,6 @@ void DrawScrollMode(struct AppState& s, Font f);
 void DrawBookMode(struct AppState& s, Font f);
 void DrawTooltip(struct AppState& s, Font f);
 
-#include <condition_variable>
-#include <functional>
-#include <queue>
-
 #include <set>
 
 struct NavPoint {
@@ -25,6 +22,16 @@ struct NavPoint {
     int chNum;
 };
 
+// The chapters on screen. Never changed once published: a worker copies the current one,
+// edits the copy and swaps it in, so the render loop reads a consistent set without locking.
+struct BufferSnapshot {
+    std::deque<ChapterRef> buf;  // Primary column
+    std::deque<ChapterRef> buf2; // Parallel column, index-aligned with buf
+    int anchorBook = 42;         // Position of buf.front()
+    int anchorCh   = 3;
+};
+using SnapshotRef = std::shared_ptr<const BufferSnapshot>;
+
 struct AppState {
     // --- Navigation History ---
     std::vector<NavPoint> navHistory;
@@ -42,24 +49,27 @@ struct AppState {
     char tooltip[64]{};
     std::atomic<bool> isLoading{false};
     std::atomic<bool> needsPageRebuild{false};
-    std::mutex bufferMutex;
+    std::atomic<int> firstVerseMs{-1}; // Last navigation's wait until its chapter was in the buffer
+    bool wasOffline = false; // Last network state Update saw, to announce changes once
+    std::mutex bufferMutex; // Serializes snapshot writers and guards what workers post for Update
+    std::atomic<bool> workerPosted{false}; // Set after posting, so Update only locks when there is something to take
 
     // --- Threading ---
-    std::thread workerThread;
-    std::mutex queueMutex;
-    std::condition_variable queueCondVar;
-    std::queue<std::function<void()>> taskQueue;
-    std::atomic<bool> quitWorker{false};
+    TaskScheduler scheduler;
+    CancelToken navToken;    // The navigation in flight; a newer InitBuffer cancels it
+    CancelToken lookupToken; // The Strong's lookup in flight; a newer click cancels it
 
-    void PushTask(std::function<void()> task, bool clearQueue = false);
-    void WorkerLoop();
+    // --- Prefetch ---
+    int readDir = 1; // +1 reading onward, -1 backward; set by growth and sequential moves
+    std::atomic<bool> needsPrefetch{false}; // Buffer settled somewhere new since the last guesses
+    void QueuePrefetch();
 
     // --- Global Search ---
     bool showGlobalSearch = false;
     char gSearchBuf[256]{};
     std::vector<GlobalSearchMatch> gSearchResults;
-    bool gSearchActive = false;
-    int gSearchProgress = 0;
+    std::atomic<bool> gSearchActive{false};
+    std::atomic<int> gSearchProgress{0}; // Books fully searched
     float gSearchThreadTimer = 0;
 
     // --- UI Layout ---
@@ -76,8 +86,11 @@ struct AppState {
 
     // --- Word Study ---
     bool showWordStudy = false;
-    StrongsDef currentStrongs;
-    void LookupStrongs(const std::string& number);
+    StrongsDef currentStrongs;  // Main thread only
+    StrongsDef fetchedStrongs;  // Posted by a worker; Update moves it into currentStrongs
+    std::atomic<bool> needsLexicon{true}; // Buffer changed since its Strong's numbers were queued for prefetch
+    void LookupStrongs(int bookIdx, uint32_t number); // bookIdx of the chapter the tag is in, which picks H or G
+    void QueueLexicon();
 
     // --- Current position ---
     int  curBookIdx = 42;
@@ -86,11 +99,11 @@ struct AppState {
     std::string trans;
 
     // --- Multi-chapter ring buffer ---
-    std::deque<Chapter> buf;
-    std::deque<Chapter> buf2;
-    int  bufAnchorBook = 42;
-    int  bufAnchorCh   = 3;
+    SnapshotRef published = std::make_shared<BufferSnapshot>(); // Swapped atomically by writers
+    SnapshotRef view = published; // Main thread's copy, taken once a frame by Update
     static const int BUF_MAX = 5;
+    SnapshotRef Snapshot() const { return std::atomic_load(&published); }
+    void Publish(std::shared_ptr<BufferSnapshot> next); // Caller holds bufferMutex
 
     // --- Scroll mode ---
     float scrollY = 0.0f;
@@ -142,6 +155,10 @@ struct AppState {
     // --- Status toast ---
     std::string statusMsg;
     float       statusTimer = 0.0f;
+    std::string workerStatus; // Posted by a worker; Update shows it
+    std::vector<GlobalSearchMatch> postedSearch; // Posted by the search task; Update moves it into gSearchResults
+    NavPoint postedNav{-1, 0};                   // Posted by a navigation; Update pushes it onto navHistory
+
 
     // --- Colors ---
     Color bg, text, accent, hdr, vnum, ok, err, pageBg, pageShadow;
@@ -154,6 +171,7 @@ struct AppState {
     void SetStatus(const std::string& msg, float secs = 2.5f);
     void InitBuffer(bool resetScroll = true);
     void ToggleParallelMode(Font font);
+    std::pair<ChapterRef, ChapterRef> LoadColumns(int b, int c);
     void GrowBottom();
     void GrowTop();
     void RebuildPages(Font font);
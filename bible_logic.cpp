@@ -1,11 +1,75 @@
 #include "bible_logic.h"
 #include "utils.h"
+#include "markup.h"
+#include "http_client.h"
 #include "managers.h"
+#include "json.h"
 #include <sstream>
 #include <algorithm>
+#include <cstring>
 
-Chapter FetchFromAPI(int bookIdx, int chNum, const std::string& trans) {
-    Chapter r{};
+// --- Chapter arenas ---
+
+void Chapter::Grow(size_t textBytes, size_t tagCount) {
+    if (textArena.size() + textBytes > textArena.capacity()) MoveText(std::max(textArena.capacity() * 2, textArena.size() + textBytes));
+    if (tagArena.size() + tagCount > tagArena.capacity()) MoveTags(std::max(tagArena.capacity() * 2, tagArena.size() + tagCount));
+}
+
+void Chapter::MoveText(size_t capacity) {
+    std::vector<char> t; t.reserve(capacity);
+    t.insert(t.end(), textArena.begin(), textArena.end());
+    for (auto& v : verses) v.text = std::string_view(t.data() + (v.text.data() - textArena.data()), v.text.size());
+    textArena.swap(t);
+}
+
+void Chapter::MoveTags(size_t capacity) {
+    std::vector<StrongsTag> t; t.reserve(capacity);
+    t.insert(t.end(), tagArena.begin(), tagArena.end());
+    for (auto& v : verses) if (v.tags.count) v.tags.ptr = t.data() + (v.tags.ptr - tagArena.data());
+    tagArena.swap(t);
+}
+
+void Chapter::Fit() {
+    if (textArena.capacity() - textArena.size() > textArena.size() / 8) MoveText(textArena.size());
+    if (tagArena.empty()) tagArena = {};
+    else if (tagArena.capacity() - tagArena.size() > tagArena.size() / 8) MoveTags(tagArena.size());
+    verses.shrink_to_fit();
+}
+
+void Chapter::Reserve(size_t verseCount, size_t textBytes, size_t tagCount) {
+    verses.reserve(verses.size() + verseCount);
+    Grow(textBytes + verseCount, tagCount); // One terminator per verse
+}
+
+void Chapter::AddVerse(int number, std::string_view text, const StrongsTag* tags, size_t tagCount) {
+    Grow(text.size() + 1, tagCount);
+    size_t off = textArena.size(), tagOff = tagArena.size();
+    textArena.insert(textArena.end(), text.begin(), text.end()); textArena.push_back('\0');
+    if (tagCount) { tagArena.resize(tagOff + tagCount); memcpy(&tagArena[tagOff], tags, tagCount * sizeof(StrongsTag)); }
+    verses.push_back({number, std::string_view(textArena.data() + off, text.size()), TagSpan{tagCount ? tagArena.data() + tagOff : nullptr, tagCount}});
+}
+
+bool Chapter::AddTaggedVerse(int number, std::string_view raw) {
+    Grow(raw.size() + 1, raw.size() / 4 + 1); // Upper bounds (a tag takes at least 4 bytes), so cleaning below never reallocates
+    size_t off = textArena.size(), tagOff = tagArena.size();
+    size_t len = CleanVerseText(raw, textArena, tagArena);
+    if (len == 0) { tagArena.resize(tagOff); return false; }
+    textArena.push_back('\0');
+    size_t tagCount = tagArena.size() - tagOff;
+    verses.push_back({number, std::string_view(textArena.data() + off, len), TagSpan{tagCount ? tagArena.data() + tagOff : nullptr, tagCount}});
+    return true;
+}
+
+std::string ChapterURL(int bookIdx, int chNum, const std::string& trans) {
+    // Use bolls.life API for more translations and better stability
+    // Format: https://bolls.life/get-text/{TRANS}/{BOOK_ID}/{CH}/
+    // Book ID is 1-based index (Genesis = 1, John = 43)
+    int bollsId = bookIdx + 1;
+    return g_settings.apiBase + "/get-text/" + trans + "/" + std::to_string(bollsId) + "/" + std::to_string(chNum) + "/";
+}
+
+bool ParseChapter(const std::string& resp, int bookIdx, int chNum, const std::string& trans, Chapter& r) {
+    r = Chapter{};
     r.bookIndex  = bookIdx;
     r.bookAbbrev = BIBLE_BOOKS[bookIdx].abbrev;
     r.chapter    = chNum;
@@ -13,61 +77,124 @@ Chapter FetchFromAPI(int bookIdx, int chNum, const std::string& trans) {
     r.fetchedAt  = time(nullptr);
     r.fromCache  = false;
     r.isLoaded   = false;
-
-    // Use bolls.life API for more translations and better stability
-    // Format: https://bolls.life/get-text/{TRANS}/{BOOK_ID}/{CH}/
-    // Book ID is 1-based index (Genesis = 1, John = 43)
-    int bollsId = bookIdx + 1;
-    std::string url = "https://bolls.life/get-text/" + trans + "/" + std::to_string(bollsId) + "/" + std::to_string(chNum) + "/";
-    
-    std::string resp = HttpGet(url);
-    if (resp.empty() || resp == "[]" || resp.find("not found") != std::string::npos) {
-        r.book = BIBLE_BOOKS[bookIdx].name + " " + std::to_string(chNum);
-        r.verses.push_back({1, "Error loading content or Translation not supported for this book. Try a different translation."});
-        r.isLoaded = true; 
-        return r;
-    }
-
     r.book = BIBLE_BOOKS[bookIdx].name + " " + std::to_string(chNum);
-    auto verseObjects = JArr(resp, ""); // Parse top-level array
-    for (const auto& vo : verseObjects) {
-        Verse v;
-        v.number = JInt(vo, "verse");
-        std::string raw = JStr(vo, "text");
-        v.rawText = raw; // Save original with tags
-        v.text   = StripTags(raw); // Clean version
-        
-        // Final polish
-        size_t p = 0;
-        while ((p = v.text.find('\n', p)) != std::string::npos) { v.text.replace(p, 1, " "); }
-        p = 0;
-        while ((p = v.text.find("  ", p)) != std::string::npos) { v.text.replace(p, 2, " "); }
-        v.text.erase(0, v.text.find_first_not_of(" \t\r"));
-        v.text.erase(v.text.find_last_not_of(" \t\r") + 1);
-
-        if (!v.text.empty()) {
-            r.verses.push_back(v);
+
+    // One pass over the top-level array of verse objects, cleaning each text straight
+    // into the chapter arena. Error objects ({"detail": "Not found."}), malformed and
+    // truncated responses yield nothing.
+    {
+        JsonReader j(resp);
+        if (j.Next() != JsonReader::ArrayBegin) return false;
+        // Clean text never outgrows the response, every tag comes from a "<S" and verse
+        // objects from the API run well past 128 bytes each
+        size_t tagBound = 0;
+        for (size_t p = resp.find('<'); p != std::string::npos; p = resp.find('<', p + 1)) tagBound += p + 1 < resp.size() && (resp[p + 1] == 'S' || resp[p + 1] == 's');
+        r.Reserve(resp.size() / 128, resp.size(), tagBound);
+        std::string owned;
+        while (j.Next() == JsonReader::ObjectBegin) {
+            int number = 0; std::string_view text; bool hasNumber = false, hasText = false;
+            while (j.Next() == JsonReader::Key) {
+                bool isVerse = j.Str() == "verse", isText = j.Str() == "text";
+                j.Next();
+                if (isVerse) { number = (int)j.Int(); hasNumber = true; }
+                else if (isText && j.Tok() == JsonReader::String) {
+                    // The API sends "verse" first, so the text is cleaned from the response (or the
+                    // decode buffer) directly; only text that precedes its number is held on to
+                    if (hasNumber) r.AddTaggedVerse(number, j.Str());
+                    else { hasText = true; text = j.Escaped() ? std::string_view(owned.assign(j.Str())) : j.Str(); }
+                }
+                else if (!j.SkipValue()) break;
+            }
+            if (j.Tok() != JsonReader::ObjectEnd) break;
+            if (hasText) r.AddTaggedVerse(number, text);
         }
+        if (j.Tok() != JsonReader::ArrayEnd) { r.verses.clear(); return false; }
     }
-    
-    if (!r.verses.empty()) { 
-        g_cache.Save(r); 
+    r.Fit(); // Hand back the response-sized reservation now that the index is gone
+    r.isLoaded = !r.verses.empty();
+    return r.isLoaded;
+}
+
+Chapter FetchFromAPI(int bookIdx, int chNum, const std::string& trans) {
+    HttpResponse resp = g_transport->Request(ChapterURL(bookIdx, chNum, trans));
+    return ChapterFromResponse(resp.body, bookIdx, chNum, trans, resp.etag);
+}
+
+Chapter ChapterFromResponse(const std::string& resp, int bookIdx, int chNum, const std::string& trans, const std::string& etag) {
+    Chapter r;
+    if (ParseChapter(resp, bookIdx, chNum, trans, r)) {
+        r.etag = etag;
+        g_cache.Save(r);
+    } else if (resp.empty() && g_transport->Offline()) {
+        r.AddVerse(1, "You are offline and this chapter has not been saved for offline reading yet. It will load once the connection is back.");
+        r.isLoaded = true;
+    } else if (resp.empty() || resp == "[]" || resp.find("not found") != std::string::npos) {
+        r.AddVerse(1, "Error loading content or Translation not supported for this book. Try a different translation.");
         r.isLoaded = true; 
     } else {
-        r.verses.push_back({1, "Passage found but contains no verses."});
+        r.AddVerse(1, "Passage found but contains no verses.");
         r.isLoaded = true;
     }
     return r;
 }
 
-Chapter LoadOrFetch(int bookIdx, int chNum, const std::string& trans) {
-    if (g_cache.Has(trans, BIBLE_BOOKS[bookIdx].abbrev, chNum)) {
-        Chapter ch = g_cache.Load(trans, BIBLE_BOOKS[bookIdx].abbrev, chNum);
-        ch.bookIndex  = bookIdx;
-        ch.bookAbbrev = BIBLE_BOOKS[bookIdx].abbrev;
-        return ch;
+ChapterRef LoadCached(int bookIdx, int chNum, const std::string& trans) {
+    if (ChapterRef hit = g_chapters.Get(trans, bookIdx, chNum)) return hit;
+    const std::string& ba = BIBLE_BOOKS[bookIdx].abbrev;
+    if (!g_cache.Has(trans, ba, chNum)) return nullptr;
+    auto ch = std::make_shared<Chapter>(g_cache.Load(trans, ba, chNum));
+    if (!ch->isLoaded) { g_cache.Remove(trans, ba, chNum); return nullptr; } // Corrupt record: drop it and refetch
+    ch->bookIndex  = bookIdx;
+    ch->bookAbbrev = ba;
+    g_chapters.Put(trans, ch);
+    return ch;
+}
+
+static ChapterRef AdoptFetched(Chapter&& fetched, int bookIdx, int chNum, const std::string& trans) {
+    auto ch = std::make_shared<Chapter>(std::move(fetched));
+    ch->bookIndex  = bookIdx;
+    ch->bookAbbrev = BIBLE_BOOKS[bookIdx].abbrev;
+    // Only chapters that made it into the disk cache are real content; error placeholders stay uncached
+    if (g_cache.Has(trans, ch->bookAbbrev, chNum)) g_chapters.Put(trans, ch);
+    return ch;
+}
+
+ChapterRef LoadOrFetch(int bookIdx, int chNum, const std::string& trans) {
+    if (ChapterRef ch = LoadCached(bookIdx, chNum, trans)) return ch;
+    return AdoptFetched(FetchFromAPI(bookIdx, chNum, trans), bookIdx, chNum, trans);
+}
+
+Revalidation RevalidateChapter(int bookIdx, int chNum, const std::string& trans, ChapterRef& out) {
+    out = LoadCached(bookIdx, chNum, trans);
+    HttpResponse resp = out ? g_transport->Request(ChapterURL(bookIdx, chNum, trans), out->etag, out->fetchedAt) : g_transport->Request(ChapterURL(bookIdx, chNum, trans));
+    if (out && resp.status == 304) return Revalidation::Unchanged;
+    Chapter fresh;
+    if (resp.status != 200 || !ParseChapter(resp.body, bookIdx, chNum, trans, fresh)) return Revalidation::Failed; // The cached copy, if any, stays
+    fresh.etag = resp.etag;
+    g_cache.Save(fresh);
+    out = AdoptFetched(std::move(fresh), bookIdx, chNum, trans);
+    return Revalidation::Updated;
+}
+
+void LoadOrFetchMany(const std::vector<ChapterRequest>& reqs, const std::function<void(size_t, ChapterRef)>& ready) {
+    // Cached chapters are handed over straight away; the rest go out as one batch, and a
+    // chapter asked for twice (same translation in both columns) is fetched once
+    std::vector<std::string> urls;
+    std::vector<std::vector<size_t>> waiting; // Request indices per URL
+    for (size_t i = 0; i < reqs.size(); i++) {
+        const ChapterRequest& r = reqs[i];
+        if (ChapterRef ch = LoadCached(r.bookIdx, r.chNum, r.trans)) { ready(i, ch); continue; }
+        std::string url = ChapterURL(r.bookIdx, r.chNum, r.trans);
+        size_t u = std::find(urls.begin(), urls.end(), url) - urls.begin();
+        if (u == urls.size()) { urls.push_back(url); waiting.emplace_back(); }
+        waiting[u].push_back(i);
     }
-    return FetchFromAPI(bookIdx, chNum, trans);
+    if (urls.empty()) return;
+    g_transport->GetMany(urls, [&](size_t u, HttpResponse resp) {
+        const ChapterRequest& r = reqs[waiting[u][0]];
+        ChapterRef ch = AdoptFetched(ChapterFromResponse(resp.body, r.bookIdx, r.chNum, r.trans, resp.etag), r.bookIdx, r.chNum, r.trans);
+        for (size_t i : waiting[u]) ready(i, ch);
+    });
 }
 
 bool NextChapter(int& bookIdx, int& chNum) {
@@ -129,16 +256,18 @@ std::vector<std::pair<int, int>> GetDailyReading(int dayOfYear) {
     return r;
 }
 
-std::vector<SearchMatch> SearchVerses(const std::deque<Chapter>& chapters, const std::string& q, bool cs) {
+std::vector<SearchMatch> SearchVerses(const std::deque<ChapterRef>& chapters, const std::string& q, bool cs) {
     std::vector<SearchMatch> m;
     if (q.empty()) return m;
     std::string sq = cs ? q : ToLower(q);
-    for (const auto& ch : chapters) {
+    for (const auto& cr : chapters) {
+        const Chapter& ch = *cr;
         for (const auto& v : ch.verses) {
-            std::string st = cs ? v.text : ToLower(v.text);
+            std::string lower; std::string_view st = v.text;
+            if (!cs) { lower = ToLower(v.text); st = lower; }
             size_t p = 0;
-            while ((p = st.find(sq, p)) != std::string::npos) {
-                m.push_back({ch.bookIndex, ch.chapter, v.number, v.text, p, sq.size()});
+            while ((p = st.find(sq, p)) != std::string_view::npos) {
+                m.push_back({ch.bookIndex, ch.chapter, v.number, std::string(v.text), p, sq.size()});
                 p += sq.size();
             }
         }
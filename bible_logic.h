@@ -5,13 +5,32 @@
 #include "raybible.h"
 #include <string>
 #include <vector>
+#include <functional>
 
+struct ChapterRequest {
+    int bookIdx;
+    int chNum;
+    std::string trans;
+};
+
+std::string ChapterURL(int bookIdx, int chNum, const std::string& trans);
+bool ParseChapter(const std::string& resp, int bookIdx, int chNum, const std::string& trans, Chapter& out);
 Chapter FetchFromAPI(int bookIdx, int chNum, const std::string& trans);
-Chapter LoadOrFetch(int bookIdx, int chNum, const std::string& trans);
+Chapter ChapterFromResponse(const std::string& resp, int bookIdx, int chNum, const std::string& trans, const std::string& etag = ""); // Parsed and cached, or an error placeholder
+ChapterRef LoadCached(int bookIdx, int chNum, const std::string& trans);
+ChapterRef LoadOrFetch(int bookIdx, int chNum, const std::string& trans);
+// Conditional refetch: the cached copy's ETag and fetchedAt go out as If-None-Match and
+// If-Modified-Since, so an unchanged chapter costs a 304. `out` is the chapter to show:
+// the fresh one if Updated, otherwise the cached one (null if there was none).
+enum class Revalidation { Unchanged, Updated, Failed };
+Revalidation RevalidateChapter(int bookIdx, int chNum, const std::string& trans, ChapterRef& out);
+// LoadOrFetch for several chapters with every network fetch in flight at once; ready(i, ch)
+// runs on the calling thread as each becomes available (cached ones first)
+void LoadOrFetchMany(const std::vector<ChapterRequest>& reqs, const std::function<void(size_t, ChapterRef)>& ready);
 bool NextChapter(int& bookIdx, int& chNum);
 bool PrevChapter(int& bookIdx, int& chNum);
 bool ParseReference(std::string input, int& bookIdx, int& chNum, int& vNum);
 std::vector<std::pair<int, int>> GetDailyReading(int dayOfYear);
-std::vector<SearchMatch> SearchVerses(const std::deque<Chapter>& chapters, const std::string& q, bool cs);
+std::vector<SearchMatch> SearchVerses(const std::deque<ChapterRef>& chapters, const std::string& q, bool cs);
 
 #endif // BIBLE_LOGIC_H
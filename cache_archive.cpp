@@ -0,0 +1,464 @@
+#include "cache_archive.h"
+#include "raybible.h"
+#include "utils.h"
+#include "codec.h"
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace {
+const char     MAGIC[4] = {'R', 'B', 'P', 'K'};
+const uint32_t VERSION  = 1;
+const uint64_t MAP_STEP = 1 << 20; // Grow the mapping in 1 MiB steps
+
+struct Header {
+    char     magic[4];
+    uint32_t version;
+    uint32_t slots;
+    uint32_t reserved;
+};
+
+uint64_t TableOffset(int slot) { return sizeof(Header) + (uint64_t)slot * sizeof(ChapterArchive::Entry); }
+
+const char     REC_MAGIC[4] = {'R', 'B', 'C', 'H'};
+const uint16_t REC_VERSION  = 2; // 1 stored tagged raw text next to the clean text
+
+struct RecordHeader {
+    char     magic[4];
+    uint16_t version;
+    uint16_t flags;
+    uint32_t checksum; // FNV-1a over everything after the header
+    uint32_t verseCount;
+    int64_t  fetchedAt;
+    int32_t  chapter;
+    uint32_t bookLen;
+    uint32_t transLen;
+    uint32_t etagLen; // Zero in records written before ETags were kept
+};
+
+struct VerseSpan {
+    int32_t  number;
+    uint32_t textOff, textLen;
+    uint32_t tagOff, tagCount; // StrongsTag array; version 1: offset/length of the raw text
+};
+
+uint32_t Fnv1a(const char* p, size_t n) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < n; i++) { h ^= (unsigned char)p[i]; h *= 16777619u; }
+    return h;
+}
+
+// Fills the header and returns false if the record is truncated or corrupt
+bool CheckRecord(std::string_view rec, RecordHeader& h) {
+    if (rec.size() < sizeof(RecordHeader)) return false;
+    memcpy(&h, rec.data(), sizeof(h));
+    if (memcmp(h.magic, REC_MAGIC, 4) != 0 || (h.version != REC_VERSION && h.version != 1)) return false;
+    uint64_t fixed = sizeof(RecordHeader) + (uint64_t)h.verseCount * sizeof(VerseSpan) + h.bookLen + h.transLen + h.etagLen;
+    if (fixed > rec.size()) return false;
+    return Fnv1a(rec.data() + sizeof(RecordHeader), rec.size() - sizeof(RecordHeader)) == h.checksum;
+}
+
+const char LZ_MAGIC[4] = {'R', 'B', 'L', 'Z'};
+
+struct FrameHeader {
+    char     magic[4];
+    uint32_t dictId;
+    uint32_t rawLen;
+};
+
+bool IsFrame(std::string_view stored, FrameHeader& f) {
+    if (stored.size() < sizeof(FrameHeader)) return false;
+    memcpy(&f, stored.data(), sizeof(f));
+    return memcmp(f.magic, LZ_MAGIC, 4) == 0;
+}
+}
+
+int TotalChapters() {
+    static const int total = [] { int n = 0; for (const auto& b : BIBLE_BOOKS) n += b.chapters; return n; }();
+    return total;
+}
+
+int ChapterSlot(int bookIdx, int ch) {
+    static const std::vector<int> starts = [] {
+        std::vector<int> s; int n = 0;
+        for (const auto& b : BIBLE_BOOKS) { s.push_back(n); n += b.chapters; }
+        return s;
+    }();
+    if (bookIdx < 0 || bookIdx >= (int)starts.size()) return -1;
+    if (ch < 1 || ch > BIBLE_BOOKS[bookIdx].chapters) return -1;
+    return starts[bookIdx] + ch - 1;
+}
+
+int BookIndexOf(const std::string& abbrev) {
+    for (int i = 0; i < (int)BIBLE_BOOKS.size(); i++) if (BIBLE_BOOKS[i].abbrev == abbrev) return i;
+    return -1;
+}
+
+// --- Chapter records ---
+
+std::string EncodeChapterRecord(const Chapter& ch) {
+    size_t strBytes = ch.book.size() + ch.translation.size() + ch.etag.size();
+    for (const auto& v : ch.verses) strBytes += v.text.size() + v.tags.size() * sizeof(StrongsTag);
+    size_t spanStart = sizeof(RecordHeader), strStart = spanStart + ch.verses.size() * sizeof(VerseSpan);
+    std::string rec(strStart + strBytes, '\0');
+
+    RecordHeader h{};
+    memcpy(h.magic, REC_MAGIC, 4); h.version = REC_VERSION;
+    h.verseCount = (uint32_t)ch.verses.size(); h.fetchedAt = (int64_t)ch.fetchedAt; h.chapter = ch.chapter;
+    h.bookLen = (uint32_t)ch.book.size(); h.transLen = (uint32_t)ch.translation.size(); h.etagLen = (uint32_t)ch.etag.size();
+
+    char* out = &rec[0];
+    size_t pos = strStart;
+    auto put = [&](const void* p, size_t n) { uint32_t off = (uint32_t)pos; if (n) memcpy(out + pos, p, n); pos += n; return off; };
+    put(ch.book.data(), ch.book.size()); put(ch.translation.data(), ch.translation.size()); put(ch.etag.data(), ch.etag.size());
+    for (size_t i = 0; i < ch.verses.size(); i++) {
+        const Verse& v = ch.verses[i];
+        VerseSpan sp{v.number, 0, (uint32_t)v.text.size(), 0, (uint32_t)v.tags.size()};
+        sp.textOff = put(v.text.data(), v.text.size()); sp.tagOff = put(v.tags.begin(), v.tags.size() * sizeof(StrongsTag));
+        memcpy(out + spanStart + i * sizeof(VerseSpan), &sp, sizeof(sp));
+    }
+    h.checksum = Fnv1a(out + sizeof(RecordHeader), rec.size() - sizeof(RecordHeader));
+    memcpy(out, &h, sizeof(h));
+    return rec;
+}
+
+bool DecodeChapterRecord(std::string_view rec, Chapter& out) {
+    RecordHeader h;
+    if (!CheckRecord(rec, h)) return false;
+    const char* base = rec.data();
+    size_t strStart = sizeof(RecordHeader) + (size_t)h.verseCount * sizeof(VerseSpan);
+    out.book.assign(base + strStart, h.bookLen);
+    out.translation.assign(base + strStart + h.bookLen, h.transLen);
+    out.etag.assign(base + strStart + h.bookLen + h.transLen, h.etagLen);
+    out.chapter = h.chapter;
+    out.fetchedAt = (time_t)h.fetchedAt;
+    out.verses.clear();
+    std::vector<VerseSpan> spans(h.verseCount);
+    if (h.verseCount) memcpy(spans.data(), base + sizeof(RecordHeader), h.verseCount * sizeof(VerseSpan));
+    size_t textBytes = 0, tagCount = 0;
+    for (const auto& sp : spans) {
+        uint64_t tagBytes = h.version == 1 ? sp.tagCount : (uint64_t)sp.tagCount * sizeof(StrongsTag);
+        if ((uint64_t)sp.textOff + sp.textLen > rec.size() || (uint64_t)sp.tagOff + tagBytes > rec.size()) return false;
+        textBytes += h.version == 1 && sp.tagCount ? sp.tagCount : sp.textLen;
+        tagCount += h.version == 1 ? sp.tagCount / 4 + 1 : sp.tagCount;
+    }
+    out.Reserve(h.verseCount, textBytes, tagCount);
+    for (const auto& sp : spans) {
+        // Version 1 kept a raw tagged copy; its tags are lifted out of that instead
+        if (h.version == 1) { if (!(sp.tagCount && out.AddTaggedVerse(sp.number, std::string_view(base + sp.tagOff, sp.tagCount)))) out.AddVerse(sp.number, std::string_view(base + sp.textOff, sp.textLen)); continue; }
+        std::vector<StrongsTag> tags(sp.tagCount); // Copied out because the record gives no alignment guarantee
+        if (sp.tagCount) memcpy(tags.data(), base + sp.tagOff, sp.tagCount * sizeof(StrongsTag));
+        for (const auto& t : tags) if (t.pos > sp.textLen) return false;
+        out.AddVerse(sp.number, std::string_view(base + sp.textOff, sp.textLen), tags.data(), tags.size());
+    }
+    return true;
+}
+
+bool PeekChapterRecord(std::string_view rec, uint32_t& verses, int64_t& fetchedAt) {
+    RecordHeader h;
+    if (!CheckRecord(rec, h)) return false;
+    verses = h.verseCount; fetchedAt = h.fetchedAt;
+    return true;
+}
+
+// --- Compression ---
+
+void SharedDictionary::Set(std::string b) {
+    bytes = std::move(b);
+    id = bytes.empty() ? 0 : (Fnv1a(bytes.data(), bytes.size()) | 1);
+    index = LzIndexDictionary(bytes);
+}
+
+bool SharedDictionary::Load(const std::string& path) {
+    if (!FileExists(path)) { Set(""); return false; }
+    Set(ReadFile(path));
+    return id != 0;
+}
+
+bool SharedDictionary::Save(const std::string& path) const { return WriteFileAtomic(path, bytes); }
+
+std::string CompressRecord(std::string_view rec, const SharedDictionary& dict) {
+    std::string body = LzCompress(rec, dict.bytes, dict.index);
+    if (body.size() + sizeof(FrameHeader) >= rec.size()) return std::string(rec);
+    FrameHeader f{};
+    memcpy(f.magic, LZ_MAGIC, 4); f.dictId = dict.id; f.rawLen = (uint32_t)rec.size();
+    std::string out((const char*)&f, sizeof(f));
+    return out + body;
+}
+
+uint32_t LogicalRecordSize(std::string_view stored) {
+    FrameHeader f;
+    return IsFrame(stored, f) ? f.rawLen : (uint32_t)stored.size();
+}
+
+bool ExpandRecord(std::string_view stored, const SharedDictionary& dict, std::string& scratch, std::string_view& rec) {
+    FrameHeader f;
+    if (!IsFrame(stored, f)) { rec = stored; return true; }
+    if (f.dictId != 0 && f.dictId != dict.id) return false; // Trained with a dictionary we no longer have
+    if (!LzDecompress(stored.substr(sizeof(f)), f.dictId ? std::string_view(dict.bytes) : std::string_view(), f.rawLen, scratch)) return false;
+    rec = scratch;
+    return true;
+}
+
+// --- ChapterArchive ---
+
+ChapterArchive::ChapterArchive(const std::string& p) : path(p) {}
+ChapterArchive::~ChapterArchive() { Close(); }
+
+#ifdef _WIN32
+bool ChapterArchive::PWrite(const void* data, size_t len, uint64_t off) {
+    OVERLAPPED ov{}; ov.Offset = (DWORD)(off & 0xFFFFFFFF); ov.OffsetHigh = (DWORD)(off >> 32);
+    DWORD w = 0;
+    return WriteFile((HANDLE)fd, data, (DWORD)len, &w, &ov) && w == len;
+}
+bool ChapterArchive::PRead(void* data, size_t len, uint64_t off) const {
+    OVERLAPPED ov{}; ov.Offset = (DWORD)(off & 0xFFFFFFFF); ov.OffsetHigh = (DWORD)(off >> 32);
+    DWORD r = 0;
+    return ReadFile((HANDLE)fd, data, (DWORD)len, &r, &ov) && r == len;
+}
+void ChapterArchive::Unmap() {
+    if (map) UnmapViewOfFile(map);
+    if (mapHandle) CloseHandle((HANDLE)mapHandle);
+    map = nullptr; mapHandle = nullptr; mapLen = 0;
+}
+bool ChapterArchive::Remap(uint64_t need) {
+    if (need <= mapLen) return true;
+    Unmap();
+    mapHandle = CreateFileMappingA((HANDLE)fd, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!mapHandle) return false;
+    map = (const char*)MapViewOfFile((HANDLE)mapHandle, FILE_MAP_READ, 0, 0, 0);
+    if (!map) { Unmap(); return false; }
+    mapLen = fileEnd;
+    return true;
+}
+#else
+bool ChapterArchive::PWrite(const void* data, size_t len, uint64_t off) {
+    const char* p = (const char*)data;
+    while (len > 0) {
+        ssize_t w = pwrite((int)fd, p, len, (off_t)off);
+        if (w <= 0) return false;
+        p += w; len -= (size_t)w; off += (uint64_t)w;
+    }
+    return true;
+}
+bool ChapterArchive::PRead(void* data, size_t len, uint64_t off) const {
+    return pread((int)fd, data, len, (off_t)off) == (ssize_t)len;
+}
+void ChapterArchive::Unmap() {
+    if (map) munmap((void*)map, mapLen);
+    map = nullptr; mapLen = 0;
+}
+bool ChapterArchive::Remap(uint64_t need) {
+    if (need <= mapLen) return true;
+    Unmap();
+    // Mapping past EOF is fine: only committed ranges below fileEnd are ever touched.
+    uint64_t cap = (need + MAP_STEP - 1) / MAP_STEP * MAP_STEP;
+    void* m = mmap(nullptr, cap, PROT_READ, MAP_SHARED, (int)fd, 0);
+    if (m == MAP_FAILED) return false;
+    map = (const char*)m; mapLen = cap;
+    return true;
+}
+#endif
+
+bool ChapterArchive::Open(bool create) {
+    if (IsOpen()) return true;
+#ifdef _WIN32
+    HANDLE h = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, create ? OPEN_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (h == INVALID_HANDLE_VALUE) return false;
+    fd = (intptr_t)h;
+    LARGE_INTEGER sz; GetFileSizeEx(h, &sz);
+    uint64_t size = (uint64_t)sz.QuadPart;
+#else
+    int f = open(path.c_str(), O_RDWR | (create ? O_CREAT : 0), 0644);
+    if (f < 0) return false;
+    fd = f;
+    struct stat st; fstat(f, &st);
+    uint64_t size = (uint64_t)st.st_size;
+#endif
+    int slots = TotalChapters();
+    table.assign(slots, Entry{0, 0, 0});
+    uint64_t dataStart = TableOffset(slots);
+
+    Header h{};
+    bool valid = size >= dataStart && PRead(&h, sizeof(h), 0) && memcmp(h.magic, MAGIC, 4) == 0 && h.version == VERSION && h.slots == (uint32_t)slots
+              && PRead(table.data(), table.size() * sizeof(Entry), sizeof(Header));
+    if (!valid) {
+        // New or unreadable archive: start over with an empty table.
+        if (!create) { Close(); return false; }
+        table.assign(slots, Entry{0, 0, 0});
+        memcpy(h.magic, MAGIC, 4); h.version = VERSION; h.slots = (uint32_t)slots; h.reserved = 0;
+        if (!PWrite(&h, sizeof(h), 0) || !PWrite(table.data(), table.size() * sizeof(Entry), sizeof(Header))) { Close(); return false; }
+        size = dataStart;
+    }
+    for (auto& e : table) if (e.offset < dataStart || e.offset + e.length > size) e = Entry{0, 0, 0};
+    fileEnd = size;
+    if (!Remap(fileEnd)) { Close(); return false; }
+    return true;
+}
+
+void ChapterArchive::Close() {
+    Unmap();
+    if (!IsOpen()) return;
+#ifdef _WIN32
+    CloseHandle((HANDLE)fd);
+#else
+    close((int)fd);
+#endif
+    fd = -1;
+}
+
+bool ChapterArchive::Has(int slot) const {
+    return slot >= 0 && slot < (int)table.size() && table[slot].length > 0;
+}
+
+std::string_view ChapterArchive::Read(int slot) const {
+    if (!Has(slot) || !map) return {};
+    const Entry& e = table[slot];
+    return std::string_view(map + e.offset, e.length);
+}
+
+bool ChapterArchive::Write(int slot, std::string_view record) {
+    if (!IsOpen() || slot < 0 || slot >= (int)table.size() || record.empty()) return false;
+    Entry e{fileEnd, (uint32_t)record.size(), 0};
+    if (!PWrite(record.data(), record.size(), e.offset)) return false;
+    fileEnd += record.size();
+    if (!PWrite(&e, sizeof(e), TableOffset(slot))) return false;
+    table[slot] = e;
+    return Remap(fileEnd);
+}
+
+bool ChapterArchive::Erase(int slot) {
+    if (!Has(slot)) return false;
+    Entry e{0, 0, 0};
+    if (!PWrite(&e, sizeof(e), TableOffset(slot))) return false;
+    table[slot] = e;
+    return true;
+}
+
+int ChapterArchive::Count() const {
+    int n = 0;
+    for (const auto& e : table) if (e.length > 0) n++;
+    return n;
+}
+
+uint64_t ChapterArchive::DeadBytes() const {
+    uint64_t live = TableOffset((int)table.size());
+    for (const auto& e : table) live += e.length;
+    return fileEnd > live ? fileEnd - live : 0;
+}
+
+bool ChapterArchive::CompactCopy(const std::string& src, const std::string& dst, const std::vector<Entry>& snap, std::vector<Entry>& moved) {
+    std::ifstream in(src, std::ios::binary);
+    std::ofstream out(dst, std::ios::binary | std::ios::trunc);
+    if (!in.is_open() || !out.is_open()) return false;
+    int slots = (int)snap.size();
+    Header h{};
+    memcpy(h.magic, MAGIC, 4); h.version = VERSION; h.slots = (uint32_t)slots; h.reserved = 0;
+    moved.assign(slots, Entry{0, 0, 0});
+    out.write((const char*)&h, sizeof(h));
+    out.write((const char*)moved.data(), moved.size() * sizeof(Entry)); // Filled in by CompactFinish
+    uint64_t pos = TableOffset(slots);
+    std::string buf;
+    for (int i = 0; i < slots; i++) {
+        const Entry& e = snap[i];
+        if (e.length == 0) continue;
+        buf.resize(e.length);
+        if (!in.seekg((std::streamoff)e.offset) || !in.read(&buf[0], e.length)) return false;
+        out.write(buf.data(), buf.size());
+        moved[i] = Entry{pos, e.length, 0};
+        pos += e.length;
+    }
+    out.flush();
+    return (bool)out;
+}
+
+bool ChapterArchive::CompactFinish(const std::string& dst, const std::vector<Entry>& snap, std::vector<Entry>& moved) {
+    if (!IsOpen() || snap.size() != table.size() || moved.size() != table.size()) return false;
+    {
+        std::fstream out(dst, std::ios::binary | std::ios::in | std::ios::out);
+        if (!out.is_open() || !out.seekp(0, std::ios::end)) return false;
+        uint64_t pos = (uint64_t)out.tellp();
+        for (size_t i = 0; i < table.size(); i++) {
+            if (table[i].offset == snap[i].offset && table[i].length == snap[i].length) continue;
+            std::string_view rec = Read((int)i);
+            moved[i] = Entry{rec.empty() ? 0 : pos, (uint32_t)rec.size(), 0};
+            out.write(rec.data(), rec.size());
+            pos += rec.size();
+        }
+        out.seekp((std::streamoff)TableOffset(0));
+        out.write((const char*)moved.data(), moved.size() * sizeof(Entry));
+        out.flush();
+        if (!out) return false;
+    }
+    // The live file is closed for the swap (Windows cannot rename over an open file)
+    Close();
+    bool swapped = RenameFile(dst, path);
+    return Open(false) && swapped;
+}
+
+// --- CacheManifest ---
+
+void CacheManifest::Set(int slot, uint32_t v, uint32_t b, uint32_t l, int64_t fetchedAt) {
+    if (slot < 0 || slot >= (int)entries.size()) return;
+    Clear(slot);
+    entries[slot] = Entry{v, b, l, fetchedAt, fetchedAt};
+    if (b > 0) { chapters++; verses += v; bytes += b; logical += l; }
+    pending++;
+}
+
+void CacheManifest::Clear(int slot) {
+    if (slot < 0 || slot >= (int)entries.size() || entries[slot].bytes == 0) return;
+    Entry& e = entries[slot];
+    chapters--; verses -= e.verses; bytes -= e.bytes; logical -= e.logical;
+    e = Entry{0, 0, 0, 0, 0};
+    pending++;
+}
+
+void CacheManifest::Touch(int slot, int64_t t) {
+    if (slot < 0 || slot >= (int)entries.size() || entries[slot].bytes == 0) return;
+    entries[slot].lastAccess = t;
+    touched = true;
+}
+
+void CacheManifest::Reset() {
+    entries.assign(TotalChapters(), Entry{0, 0, 0, 0, 0});
+    chapters = 0; verses = 0; bytes = 0; logical = 0; pending = 0; touched = false;
+}
+
+bool CacheManifest::Load(const std::string& path) {
+    Reset();
+    std::istringstream iss(ReadFile(path));
+    std::string magic; int version = 0, slots = 0;
+    if (!(iss >> magic >> version >> slots) || magic != "RBMANIFEST" || (version != 2 && version != 3) || slots != TotalChapters()) return false;
+    int slot; long long v, b, l, t, a = 0;
+    // Version 2 had no access time; those chapters count as last read when fetched.
+    while (iss >> slot >> v >> b >> l >> t && (version == 2 || iss >> a)) {
+        if (slot < 0 || slot >= slots || v < 0 || b <= 0 || l <= 0) { Reset(); return false; }
+        Set(slot, (uint32_t)v, (uint32_t)b, (uint32_t)l, (int64_t)t);
+        if (version == 3) entries[slot].lastAccess = (int64_t)a;
+    }
+    if (!iss.eof()) { Reset(); return false; }
+    pending = 0; touched = false;
+    return true;
+}
+
+bool CacheManifest::Save(const std::string& path) {
+    std::ostringstream o;
+    o << "RBMANIFEST 3 " << entries.size() << "\n";
+    for (size_t i = 0; i < entries.size(); i++) {
+        const Entry& e = entries[i];
+        if (e.bytes > 0) o << i << " " << e.verses << " " << e.bytes << " " << e.logical << " " << (long long)e.fetchedAt << " " << (long long)e.lastAccess << "\n";
+    }
+    if (!WriteFileAtomic(path, o.str())) return false;
+    pending = 0; touched = false;
+    return true;
+}
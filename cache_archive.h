@@ -0,0 +1,137 @@
+#pragma once
+#ifndef RAYBIBLE_CACHE_ARCHIVE_H
+#define RAYBIBLE_CACHE_ARCHIVE_H
+
+#include "codec.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+struct Chapter;
+
+// Canonical chapter numbering: Genesis 1 is slot 0, Revelation 22 is slot 1188.
+int TotalChapters();
+int ChapterSlot(int bookIdx, int ch);
+int BookIndexOf(const std::string& abbrev);
+
+// Binary chapter record: fixed header (magic, version, checksum, verse count), a verse
+// span table, then the string bytes (book, translation, ETag, verses) the spans point
+// into. Decoding copies the spans straight into Verse objects; a bad magic, version,
+// size or checksum fails the decode.
+std::string EncodeChapterRecord(const Chapter& ch);
+bool DecodeChapterRecord(std::string_view rec, Chapter& out);
+bool PeekChapterRecord(std::string_view rec, uint32_t& verses, int64_t& fetchedAt); // Validates without decoding
+
+// Dictionary shared by every compressed record of every translation. Its id is a hash of
+// the bytes, stamped into each frame so a record is never expanded with the wrong one.
+struct SharedDictionary {
+    std::string bytes;
+    uint32_t id = 0; // 0 = no dictionary
+    LzDictIndex index; // Rebuilt by Set, so compressing a record does not re-hash the bytes
+    void Set(std::string b);
+    bool Load(const std::string& path);
+    bool Save(const std::string& path) const;
+};
+
+// Compressed frame around a chapter record: "RBLZ", dictionary id, logical length, then
+// the LZ payload. Records that do not shrink are stored as-is, so readers accept both.
+std::string CompressRecord(std::string_view rec, const SharedDictionary& dict);
+uint32_t LogicalRecordSize(std::string_view stored);
+// Points `rec` at the plain record: `stored` itself, or `scratch` after expanding a frame
+bool ExpandRecord(std::string_view stored, const SharedDictionary& dict, std::string& scratch, std::string_view& rec);
+
+// One packed file per translation: fixed header, a chapter offset table indexed by
+// slot, then chapter records appended at the end. The file is mapped read-only once,
+// so lookups and reads are plain memory accesses. A record is committed by writing
+// its bytes first and its table entry last.
+class ChapterArchive {
+public:
+    struct Entry {
+        uint64_t offset;
+        uint32_t length;
+        uint32_t reserved;
+    };
+
+    explicit ChapterArchive(const std::string& path);
+    ~ChapterArchive();
+    ChapterArchive(const ChapterArchive&) = delete;
+    ChapterArchive& operator=(const ChapterArchive&) = delete;
+
+    bool Open(bool create);
+    void Close();
+    bool IsOpen() const { return fd != -1; }
+
+    bool Has(int slot) const;
+    uint32_t Length(int slot) const { return Has(slot) ? table[slot].length : 0; }
+    std::string_view Read(int slot) const; // Valid until the next Write/Erase/Close
+    bool Write(int slot, std::string_view record);
+    bool Erase(int slot);
+
+    int Count() const;
+    uint64_t FileBytes() const { return fileEnd; }
+    uint64_t DeadBytes() const; // Space held by overwritten or erased records
+    const std::string& FilePath() const { return path; }
+
+    // Compaction rewrites the live records into a fresh file in two steps, so the caller
+    // only has to lock out writers for the second. CompactCopy copies a table snapshot
+    // through its own read handle (records never change once written); CompactFinish
+    // re-copies slots written or erased since the snapshot, then swaps the file in.
+    std::vector<Entry> Snapshot() const { return table; }
+    static bool CompactCopy(const std::string& src, const std::string& dst, const std::vector<Entry>& snap, std::vector<Entry>& moved);
+    bool CompactFinish(const std::string& dst, const std::vector<Entry>& snap, std::vector<Entry>& moved);
+
+private:
+    std::string path;
+    std::vector<Entry> table;
+    uint64_t fileEnd = 0;
+    intptr_t fd = -1;
+    const char* map = nullptr;
+    uint64_t mapLen = 0;
+#ifdef _WIN32
+    void* mapHandle = nullptr;
+#endif
+
+    bool Remap(uint64_t need);
+    void Unmap();
+    bool PWrite(const void* data, size_t len, uint64_t off);
+    bool PRead(void* data, size_t len, uint64_t off) const;
+};
+
+// Per-translation summary of an archive (presence, verse count, record size, fetch and
+// last access time), kept in memory and persisted next to it so stats and eviction never
+// touch the records.
+class CacheManifest {
+public:
+    struct Entry {
+        uint32_t verses;
+        uint32_t bytes;   // Stored size; 0 = chapter not cached
+        uint32_t logical; // Size before compression
+        int64_t  fetchedAt;
+        int64_t  lastAccess;
+    };
+
+    bool Load(const std::string& path);
+    bool Save(const std::string& path);
+    void Set(int slot, uint32_t verses, uint32_t bytes, uint32_t logical, int64_t fetchedAt);
+    void Clear(int slot);
+    void Touch(int slot, int64_t t); // Records a read; saved with the next flush
+    void Reset();
+    const Entry& Get(int slot) const { return entries[slot]; }
+
+    int      Chapters() const { return chapters; }
+    long     Verses() const { return verses; }
+    uint64_t Bytes() const { return bytes; }
+    uint64_t LogicalBytes() const { return logical; }
+    int      Pending() const { return pending + (touched ? 1 : 0); } // Changes not yet saved
+
+private:
+    std::vector<Entry> entries = std::vector<Entry>(TotalChapters(), Entry{0, 0, 0, 0, 0});
+    int chapters = 0;
+    long verses = 0;
+    uint64_t bytes = 0, logical = 0;
+    int pending = 0;
+    bool touched = false;
+};
+
+#endif // RAYBIBLE_CACHE_ARCHIVE_H
@@ -0,0 +1,160 @@
+#include "codec.h"
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <unordered_map>
+
+namespace {
+const size_t MIN_MATCH   = 4;
+const size_t MAX_OFFSET  = (1u << 24) - 1;
+const int    HASH_BITS   = 15;
+const int    CHAIN_DEPTH = 16;
+const size_t WILD        = 16; // Slack LzDecompress keeps past the output for 16-byte copies
+
+uint32_t Read32(const char* p) { uint32_t v; memcpy(&v, p, 4); return v; }
+uint32_t Hash4(const char* p) { return (Read32(p) * 2654435761u) >> (32 - HASH_BITS); }
+void Copy16(void* d, const void* s) { memcpy(d, s, 16); }
+
+void PutLength(std::string& out, size_t n) { // Continuation of a nibble that hit 15
+    while (n >= 255) { out += (char)255; n -= 255; }
+    out += (char)n;
+}
+
+bool GetLength(const unsigned char*& p, const unsigned char* end, size_t& n) {
+    unsigned char b;
+    do { if (p >= end) return false; b = *p++; n += b; } while (b == 255);
+    return true;
+}
+}
+
+LzDictIndex LzIndexDictionary(std::string_view dict) {
+    LzDictIndex x;
+    x.head.assign(1u << HASH_BITS, -1);
+    x.chain.assign(dict.size() < MIN_MATCH ? 0 : dict.size() - MIN_MATCH + 1, -1);
+    for (size_t i = 0; i < x.chain.size(); i++) { uint32_t h = Hash4(dict.data() + i); x.chain[i] = x.head[h]; x.head[h] = (int32_t)i; }
+    return x;
+}
+
+std::string LzCompress(std::string_view src, std::string_view dict) {
+    return LzCompress(src, dict, LzIndexDictionary(dict));
+}
+
+std::string LzCompress(std::string_view src, std::string_view dict, const LzDictIndex& index) {
+    // Search window is dict + src laid end to end; only src positions are emitted
+    std::string buf; buf.reserve(dict.size() + src.size());
+    buf.append(dict.data(), dict.size()); buf.append(src.data(), src.size());
+    const char* base = buf.data();
+    size_t start = dict.size(), end = buf.size();
+    // Positions below `shared` are chained in the index, which is only read; the last few
+    // dictionary positions hash bytes of src, so they go into this call's chain with it
+    size_t shared = index.chain.size();
+    std::vector<int32_t> head(index.head), local(end - shared, -1);
+    auto next = [&](int32_t c) { return (size_t)c < shared ? index.chain[c] : local[c - shared]; };
+    auto insert = [&](size_t i) { if (i + MIN_MATCH <= end) { uint32_t h = Hash4(base + i); local[i - shared] = head[h]; head[h] = (int32_t)i; } };
+    for (size_t i = shared; i < start; i++) insert(i);
+
+    std::string out; out.reserve(src.size() / 2 + 16);
+    size_t lit = start, i = start;
+    auto emit = [&](size_t litEnd, size_t off, size_t len) {
+        size_t ln = litEnd - lit, ml = len ? len - MIN_MATCH : 0;
+        out += (char)((std::min<size_t>(ln, 15) << 4) | std::min<size_t>(ml, 15));
+        if (ln >= 15) PutLength(out, ln - 15);
+        out.append(base + lit, ln);
+        if (!len) return; // Final literal run carries no match
+        out += (char)(off & 0xFF); out += (char)((off >> 8) & 0xFF); out += (char)((off >> 16) & 0xFF);
+        if (ml >= 15) PutLength(out, ml - 15);
+    };
+    while (i + MIN_MATCH <= end) {
+        size_t bestLen = 0, bestOff = 0;
+        int32_t cand = head[Hash4(base + i)];
+        for (int d = 0; d < CHAIN_DEPTH && cand >= 0 && i - cand <= MAX_OFFSET; d++, cand = next(cand)) {
+            if (Read32(base + cand) != Read32(base + i)) continue;
+            size_t n = MIN_MATCH;
+            while (i + n < end && base[cand + n] == base[i + n]) n++;
+            if (n > bestLen) { bestLen = n; bestOff = i - cand; }
+        }
+        if (bestLen < MIN_MATCH) { insert(i++); continue; }
+        emit(i, bestOff, bestLen);
+        for (size_t k = 0; k < bestLen; k++) insert(i + k);
+        i += bestLen; lit = i;
+    }
+    emit(end, 0, 0);
+    return out;
+}
+
+// Most literal runs and matches are short, so they are copied 16 bytes at a time into
+// WILD bytes of slack past the end of the output instead of through a sized memcpy
+bool LzDecompress(std::string_view src, std::string_view dict, size_t rawLen, std::string& out) {
+    out.resize(rawLen + WILD);
+    char* o = &out[0];
+    size_t pos = 0;
+    const unsigned char* p = (const unsigned char*)src.data();
+    const unsigned char* end = p + src.size();
+    while (p < end) {
+        unsigned char tok = *p++;
+        size_t ln = tok >> 4, ml = tok & 15;
+        if (ln == 15 && !GetLength(p, end, ln)) return false;
+        if (ln > (size_t)(end - p) || ln > rawLen - pos) return false;
+        if (ln <= WILD && (size_t)(end - p) >= WILD) Copy16(o + pos, p);
+        else if (ln) memcpy(o + pos, p, ln);
+        p += ln; pos += ln;
+        if (p == end) break; // Final literal run
+        if (end - p < 3) return false;
+        size_t off = p[0] | (p[1] << 8) | ((size_t)p[2] << 16); p += 3;
+        if (ml == 15 && !GetLength(p, end, ml)) return false;
+        ml += MIN_MATCH;
+        if (off == 0 || off > pos + dict.size() || ml > rawLen - pos) return false;
+        if (off > pos) { // Starts inside the dictionary, may run on into the output
+            size_t from = dict.size() - (off - pos), n = std::min(ml, off - pos);
+            memcpy(o + pos, dict.data() + from, n); pos += n; ml -= n;
+        }
+        char* d = o + pos;
+        pos += ml;
+        if (off >= WILD) { for (size_t k = 0; k < ml; k += WILD) Copy16(d + k, d + k - off); continue; }
+        // Overlapping run: what is already written repeats every `off` bytes, so each copy
+        // can take twice as much as the last
+        for (size_t step = off; ml; step *= 2) { size_t n = std::min(step, ml); memcpy(d, d - step, n); d += n; ml -= n; }
+    }
+    out.resize(rawLen);
+    return pos == rawLen;
+}
+
+std::string TrainDictionary(const std::vector<std::string>& samples, size_t capacity) {
+    const size_t K = 8, SEG = 256;
+    // How many samples each k-gram shows up in (counting a gram once per sample)
+    std::unordered_map<uint64_t, uint32_t> freq;
+    for (const auto& s : samples) {
+        std::unordered_map<uint64_t, bool> seen;
+        for (size_t i = 0; i + K <= s.size(); i++) { uint64_t g; memcpy(&g, s.data() + i, K); if (!seen[g]) { seen[g] = true; freq[g]++; } }
+    }
+    struct Seg { const std::string* s; size_t off, len; };
+    std::vector<Seg> segs;
+    for (const auto& s : samples) for (size_t off = 0; off < s.size(); off += SEG) segs.push_back({&s, off, std::min(SEG, s.size() - off)});
+
+    auto score = [&](const Seg& sg) {
+        long n = 0;
+        for (size_t i = 0; i + K <= sg.len; i++) { uint64_t g; memcpy(&g, sg.s->data() + sg.off + i, K); auto it = freq.find(g); if (it != freq.end() && it->second > 1) n += it->second; }
+        return n;
+    };
+
+    // Greedy cover: take the segment whose unclaimed grams are most frequent, then claim
+    // its grams so near-duplicate segments stop scoring. Scores only ever drop, so a
+    // stale heap entry is re-scored on pop and kept only if it still beats the runner-up.
+    std::vector<std::pair<long, size_t>> heap;
+    for (size_t j = 0; j < segs.size(); j++) heap.push_back({score(segs[j]), j});
+    std::make_heap(heap.begin(), heap.end());
+    std::vector<const Seg*> picked; size_t total = 0;
+    while (total < capacity && !heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end()); auto top = heap.back(); heap.pop_back();
+        long now = score(segs[top.second]);
+        if (now <= 0) continue;
+        if (!heap.empty() && now < heap.front().first) { heap.push_back({now, top.second}); std::push_heap(heap.begin(), heap.end()); continue; }
+        const Seg& sg = segs[top.second];
+        picked.push_back(&sg); total += sg.len;
+        for (size_t i = 0; i + K <= sg.len; i++) { uint64_t g; memcpy(&g, sg.s->data() + sg.off + i, K); freq[g] = 0; }
+    }
+    std::string dict;
+    for (auto it = picked.rbegin(); it != picked.rend(); ++it) dict.append((*it)->s->data() + (*it)->off, (*it)->len);
+    if (dict.size() > capacity) dict.erase(0, dict.size() - capacity);
+    return dict;
+}
@@ -0,0 +1,31 @@
+#pragma once
+#ifndef RAYBIBLE_CODEC_H
+#define RAYBIBLE_CODEC_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+// Byte-oriented LZ77 block codec with an optional preset dictionary. Matches may reach
+// back past the start of the block into the dictionary, so many small blocks that share
+// vocabulary compress as if they were one long stream. The format is a sequence of
+// (literal run, match) pairs, LZ4 style, with 3-byte offsets.
+std::string LzCompress(std::string_view src, std::string_view dict = {});
+bool LzDecompress(std::string_view src, std::string_view dict, size_t rawLen, std::string& out);
+
+// Match-finder state over a dictionary's own bytes: hash heads and chains for every
+// position whose 4 bytes lie inside it. Built once per dictionary; each compression
+// starts from a copy of the heads and shares the chains.
+struct LzDictIndex {
+    std::vector<int32_t> head, chain;
+};
+LzDictIndex LzIndexDictionary(std::string_view dict);
+// Same output as LzCompress(src, dict), given the index LzIndexDictionary built for dict
+std::string LzCompress(std::string_view src, std::string_view dict, const LzDictIndex& index);
+
+// Builds a dictionary of at most `capacity` bytes from sample blocks: the segments that
+// cover the most frequently repeated substrings win, best ones last (shortest offsets).
+std::string TrainDictionary(const std::vector<std::string>& samples, size_t capacity);
+
+#endif // RAYBIBLE_CODEC_H
@@ -0,0 +1,109 @@
+#include "downloader.h"
+#include "bible_logic.h"
+#include "managers.h"
+#include "utils.h"
+#include "http_client.h"
+#include <algorithm>
+
+TranslationDownloader g_downloader;
+
+TranslationDownloader::~TranslationDownloader() { Stop(); }
+
+void TranslationDownloader::Join() {
+    for (auto& t : fetchers) if (t.joinable()) t.join();
+    fetchers.clear();
+    if (writer.joinable()) writer.join();
+}
+
+bool TranslationDownloader::Start(const std::string& t, int concurrency, float requestsPerSec) {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (active) return false;
+    Join(); // Reap a previous (finished or cancelled) run
+
+    jobs.clear();
+    for (int b = 0; b < (int)BIBLE_BOOKS.size(); b++)
+        for (int c = 1; c <= BIBLE_BOOKS[b].chapters; c++)
+            if (!g_cache.Has(t, BIBLE_BOOKS[b].abbrev, c)) jobs.push_back({b, c});
+
+    trans = t; next = 0; done = 0; failed = 0; cancel = false;
+    queue.clear();
+    int n = std::max(1, std::min(concurrency, (int)jobs.size()));
+    rate = requestsPerSec > 0 ? requestsPerSec : 1e9; burst = n; tokens = burst; refilled = std::chrono::steady_clock::now();
+    if (jobs.empty()) return true;
+
+    active = true;
+    liveFetchers = n;
+    for (int i = 0; i < n; i++) fetchers.emplace_back(&TranslationDownloader::FetchLoop, this);
+    writer = std::thread(&TranslationDownloader::WriteLoop, this);
+    return true;
+}
+
+void TranslationDownloader::Cancel() {
+    { std::lock_guard<std::mutex> lock(qMtx); cancel = true; } // Under qMtx so no waiter misses the wakeup
+    qPush.notify_all(); qPop.notify_all();
+}
+
+void TranslationDownloader::Stop() { Cancel(); std::lock_guard<std::mutex> lock(mtx); Join(); }
+
+DownloadProgress TranslationDownloader::Progress() const {
+    DownloadProgress p;
+    { std::lock_guard<std::mutex> lock(mtx); p.translation = trans; p.total = (int)jobs.size(); }
+    p.done = done; p.failed = failed; p.active = active; p.cancelled = cancel;
+    return p;
+}
+
+bool TranslationDownloader::Acquire() {
+    while (!cancel) {
+        double wait;
+        if (g_transport->Offline()) { std::this_thread::sleep_for(std::chrono::milliseconds(50)); continue; } // Paused until the client's probe gets through
+        {
+            std::lock_guard<std::mutex> lock(rateMtx);
+            auto now = std::chrono::steady_clock::now();
+            tokens = std::min(burst, tokens + std::chrono::duration<double>(now - refilled).count() * rate);
+            refilled = now;
+            if (tokens >= 1.0) { tokens -= 1.0; return true; }
+            wait = (1.0 - tokens) / rate;
+        }
+        std::this_thread::sleep_for(std::chrono::duration<double>(std::min(wait, 0.05))); // Short naps keep Cancel responsive
+    }
+    return false;
+}
+
+void TranslationDownloader::FetchLoop() {
+    while (!cancel) {
+        size_t i = next++;
+        if (i >= jobs.size() || !Acquire()) break;
+        Result r{jobs[i], g_transport->Request(ChapterURL(jobs[i].bookIdx, jobs[i].ch, trans))};
+        std::unique_lock<std::mutex> lock(qMtx);
+        qPop.wait(lock, [&] { return cancel || queue.size() < queueCap; });
+        if (cancel) break;
+        queue.push_back(std::move(r));
+        qPush.notify_one();
+    }
+    std::lock_guard<std::mutex> lock(qMtx);
+    liveFetchers--;
+    qPush.notify_one();
+}
+
+void TranslationDownloader::WriteLoop() {
+    for (;;) {
+        Result r;
+        {
+            std::unique_lock<std::mutex> lock(qMtx);
+            qPush.wait(lock, [&] { return cancel || !queue.empty() || liveFetchers == 0; });
+            if (cancel || queue.empty()) break;
+            r = std::move(queue.front());
+            queue.pop_front();
+            qPop.notify_one();
+        }
+        Chapter ch;
+        bool ok = ParseChapter(r.resp.body, r.job.bookIdx, r.job.ch, trans, ch);
+        if (ok) { ch.etag = std::move(r.resp.etag); ok = g_cache.Save(ch); }
+        if (ok) done++; else failed++;
+    }
+    // Fetchers still inside a request after a cancel keep the run active, so a new Start
+    // is refused rather than joining them on the UI thread
+    std::unique_lock<std::mutex> lock(qMtx);
+    qPush.wait(lock, [&] { return liveFetchers == 0; });
+    active = false;
+}
@@ -0,0 +1,72 @@
+#pragma once
+#ifndef RAYBIBLE_DOWNLOADER_H
+#define RAYBIBLE_DOWNLOADER_H
+
+#include "transport.h"
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+
+struct DownloadProgress {
+    std::string translation;
+    int total = 0;   // Chapters missing from the cache when the download started
+    int done = 0;    // Fetched and stored
+    int failed = 0;  // Network or parse failures (picked up again by the next Start)
+    bool active = false;
+    bool cancelled = false;
+};
+
+// Fills the disk cache with every chapter of one translation. A few fetcher threads pull
+// chapters off a shared job list through a token-bucket rate limiter and hand raw
+// responses to a bounded queue; a single writer thread parses them and appends them to
+// the archive, so the archive only ever sees one writer. Chapters already cached are
+// skipped, so a cancelled or partly failed download resumes where it stopped.
+// While the HTTP client is offline the fetchers wait instead of failing every chapter.
+class TranslationDownloader {
+public:
+    ~TranslationDownloader();
+    bool Start(const std::string& trans, int concurrency, float requestsPerSec);
+    void Cancel(); // Returns immediately; in-flight requests finish in the background, Active until they do
+    void Stop();   // Cancel and wait for every thread
+    bool Active() const { return active; }
+    DownloadProgress Progress() const;
+
+private:
+    struct Job { int bookIdx; int ch; };
+    struct Result { Job job; HttpResponse resp; };
+
+    std::string trans;
+    std::vector<Job> jobs;
+    std::atomic<size_t> next{0};
+    std::atomic<int> done{0}, failed{0};
+    std::atomic<bool> active{false}, cancel{false};
+    std::vector<std::thread> fetchers;
+    std::thread writer;
+    mutable std::mutex mtx; // Guards trans and the thread handles
+
+    // Bounded hand-off between fetchers and the writer
+    std::mutex qMtx;
+    std::condition_variable qPush, qPop;
+    std::deque<Result> queue;
+    size_t queueCap = 16;
+    int liveFetchers = 0;
+
+    // Token bucket: refills at `rate` tokens/sec up to `burst`
+    std::mutex rateMtx;
+    double rate = 0, burst = 1, tokens = 0;
+    std::chrono::steady_clock::time_point refilled;
+
+    bool Acquire();
+    void FetchLoop();
+    void WriteLoop();
+    void Join(); // Caller holds mtx
+};
+
+extern TranslationDownloader g_downloader;
+
+#endif // RAYBIBLE_DOWNLOADER_H
@@ -0,0 +1,329 @@
+#include "http_client.h"
+#include "utils.h"
+#include <algorithm>
+#include <deque>
+#include <chrono>
+#include <random>
+
+#ifdef _WIN32
+    #include <windows.h>
+    #include <wininet.h>
+#else
+    #include <curl/curl.h>
+#endif
+
+HttpClient g_http;
+
+static bool Transient(const HttpResponse& r) { return r.status == 0 || r.status == 429 || r.status >= 500; }
+
+#ifdef _WIN32
+// WinINet pools keep-alive connections per session handle, so one session for the life
+// of the app is what gives reuse; connect and request handles are cheap per call.
+void HttpClient::Init() {
+    share = InternetOpenA("RayBible/1.0", INTERNET_OPEN_TYPE_DIRECT, NULL, NULL, 0);
+    if (!share) return;
+    BOOL decode = TRUE; // Inflate gzip/deflate bodies
+    InternetSetOptionA((HINTERNET)share, INTERNET_OPTION_HTTP_DECODING, &decode, sizeof(decode));
+    DWORD connectMs = (DWORD)connectTimeout * 1000, stallMs = (DWORD)stallTimeout * 1000;
+    InternetSetOptionA((HINTERNET)share, INTERNET_OPTION_CONNECT_TIMEOUT, &connectMs, sizeof(connectMs));
+    InternetSetOptionA((HINTERNET)share, INTERNET_OPTION_SEND_TIMEOUT, &stallMs, sizeof(stallMs));
+    InternetSetOptionA((HINTERNET)share, INTERNET_OPTION_RECEIVE_TIMEOUT, &stallMs, sizeof(stallMs));
+}
+
+void HttpClient::Cleanup() {
+    if (share) InternetCloseHandle((HINTERNET)share);
+}
+
+HttpResponse HttpClient::Perform(const std::string& url, const std::string& etag, time_t since) {
+    requests++;
+    HttpResponse r;
+    char host[256], path[2048];
+    URL_COMPONENTSA uc = {sizeof(uc)};
+    uc.lpszHostName = host; uc.dwHostNameLength = sizeof(host);
+    uc.lpszUrlPath = path; uc.dwUrlPathLength = sizeof(path);
+    if (!share || !InternetCrackUrlA(url.c_str(), 0, 0, &uc)) return r;
+    HINTERNET hc = InternetConnectA((HINTERNET)share, host, uc.nPort, NULL, NULL, INTERNET_SERVICE_HTTP, 0, 0);
+    if (!hc) return r;
+    // RELOAD keeps WinINet's own cache from answering, so a 304 reaches us as one
+    DWORD flags = INTERNET_FLAG_KEEP_CONNECTION | INTERNET_FLAG_RELOAD | INTERNET_FLAG_NO_CACHE_WRITE | (uc.nScheme == INTERNET_SCHEME_HTTPS ? INTERNET_FLAG_SECURE : 0);
+    HINTERNET hr = HttpOpenRequestA(hc, "GET", path, NULL, NULL, NULL, flags, 0);
+    if (!hr) { InternetCloseHandle(hc); return r; }
+    std::string headers = "Accept-Encoding: gzip, deflate\r\n";
+    if (!etag.empty()) headers += "If-None-Match: " + etag + "\r\n";
+    if (since > 0) {
+        SYSTEMTIME st; FILETIME ft; char date[INTERNET_RFC1123_BUFSIZE];
+        ULONGLONG t = ((ULONGLONG)since + 11644473600ULL) * 10000000ULL; // Unix seconds to FILETIME ticks
+        ft.dwLowDateTime = (DWORD)t; ft.dwHighDateTime = (DWORD)(t >> 32);
+        if (FileTimeToSystemTime(&ft, &st) && InternetTimeFromSystemTimeA(&st, INTERNET_RFC1123_FORMAT, date, sizeof(date))) headers += std::string("If-Modified-Since: ") + date + "\r\n";
+    }
+    if (HttpSendRequestA(hr, headers.c_str(), (DWORD)headers.size(), NULL, 0)) {
+        DWORD status = 0, len = sizeof(status);
+        if (HttpQueryInfoA(hr, HTTP_QUERY_STATUS_CODE | HTTP_QUERY_FLAG_NUMBER, &status, &len, NULL)) r.status = (long)status;
+        char tag[256]; len = sizeof(tag);
+        if (HttpQueryInfoA(hr, HTTP_QUERY_ETAG, tag, &len, NULL)) r.etag.assign(tag, len);
+        char buf[4096]; DWORD br;
+        while (InternetReadFile(hr, buf, sizeof(buf), &br) && br > 0) r.body.append(buf, br);
+    }
+    InternetCloseHandle(hr); InternetCloseHandle(hc);
+    return r;
+}
+
+// WinINet has no multi interface: one thread per request, results handed back in arrival order
+void HttpClient::GetMany(const std::vector<std::string>& urls, const std::function<void(size_t, HttpResponse)>& done) {
+    std::mutex m; std::condition_variable cv;
+    std::deque<std::pair<size_t, HttpResponse>> arrived;
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < urls.size(); i++)
+        threads.emplace_back([&, i] { HttpResponse r = Request(urls[i]); std::lock_guard<std::mutex> lock(m); arrived.emplace_back(i, std::move(r)); cv.notify_one(); });
+    for (size_t n = 0; n < urls.size(); n++) {
+        std::unique_lock<std::mutex> lock(m);
+        cv.wait(lock, [&] { return !arrived.empty(); });
+        auto r = std::move(arrived.front()); arrived.pop_front();
+        lock.unlock();
+        done(r.first, std::move(r.second));
+    }
+    for (auto& t : threads) t.join();
+}
+#else
+static_assert(CURL_LOCK_DATA_LAST <= 8, "HttpClient::shareLocks needs one mutex per curl_lock_data");
+
+static void LockShare(CURL*, curl_lock_data data, curl_lock_access, void* locks) { static_cast<std::mutex*>(locks)[data].lock(); }
+static void UnlockShare(CURL*, curl_lock_data data, void* locks) { static_cast<std::mutex*>(locks)[data].unlock(); }
+
+static size_t CurlWrite(void* c, size_t s, size_t n, std::string* o) {
+    o->append((char*)c, s * n); return s * n;
+}
+
+// Header lines arrive one per call; only the ETag of the final response is kept
+static size_t CurlHeader(char* c, size_t s, size_t n, HttpResponse* r) {
+    std::string_view line(c, s * n);
+    if (line.compare(0, 5, "HTTP/") == 0) r->etag.clear(); // Status line: a redirect's headers no longer count
+    else if (line.size() > 5 && ToLower(line.substr(0, 5)) == "etag:") {
+        line.remove_prefix(5);
+        while (!line.empty() && (line.front() == ' ' || line.front() == '\t')) line.remove_prefix(1);
+        while (!line.empty() && (line.back() == '\r' || line.back() == '\n' || line.back() == ' ')) line.remove_suffix(1);
+        r->etag.assign(line);
+    }
+    return s * n;
+}
+
+// Polled during transfers; nonzero aborts, so shutdown never waits out a stalled probe
+static int CurlProgress(void* quitting, curl_off_t, curl_off_t, curl_off_t, curl_off_t) {
+    return static_cast<std::atomic<bool>*>(quitting)->load() ? 1 : 0;
+}
+
+// Connections stay with the easy handle that opened them: curl does not support sharing
+// one connection cache between handles running on different threads, so only DNS and
+// TLS sessions go through the share handle.
+void HttpClient::Init() {
+    curl_global_init(CURL_GLOBAL_DEFAULT); // Not thread-safe; call_once keeps it to the first request
+    CURLSH* sh = curl_share_init();
+    if (!sh) return;
+    curl_share_setopt(sh, CURLSHOPT_LOCKFUNC, LockShare);
+    curl_share_setopt(sh, CURLSHOPT_UNLOCKFUNC, UnlockShare);
+    curl_share_setopt(sh, CURLSHOPT_USERDATA, shareLocks);
+    curl_share_setopt(sh, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(sh, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    share = sh;
+}
+
+void HttpClient::Cleanup() {
+    for (void* h : idle) curl_easy_cleanup((CURL*)h); // Handles first: they still point at the share
+    for (void* m : multis) curl_multi_cleanup((CURLM*)m);
+    if (share) curl_share_cleanup((CURLSH*)share);
+}
+
+void* HttpClient::Acquire() {
+    {
+        std::lock_guard<std::mutex> lock(poolMtx);
+        if (!idle.empty()) { void* h = idle.back(); idle.pop_back(); return h; }
+    }
+    CURL* curl = curl_easy_init();
+    if (!curl) return nullptr;
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, CurlWrite);
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION,CurlHeader);
+    curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, ""); // Every encoding this libcurl can inflate
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT,connectTimeout);
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT,1L);          // A read that stalls for
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, stallTimeout); // stallTimeout seconds fails
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT,       totalTimeout);
+    curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, CurlProgress);
+    curl_easy_setopt(curl, CURLOPT_XFERINFODATA,  &quitting);
+    curl_easy_setopt(curl, CURLOPT_NOPROGRESS,    0L);
+    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION,1L);
+    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER,1L);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL,      1L); // DNS timeouts must not raise SIGALRM on worker threads
+    if (share) curl_easy_setopt(curl, CURLOPT_SHARE, (CURLSH*)share);
+    return curl;
+}
+
+void HttpClient::Release(void* h, bool connected) {
+    {
+        std::lock_guard<std::mutex> lock(poolMtx);
+        if (idle.size() < maxIdle) { idle.insert(connected ? idle.end() : idle.begin(), h); return; }
+    }
+    curl_easy_cleanup((CURL*)h);
+}
+
+// Most recently used first: its connections are the likeliest to still be open
+void* HttpClient::AcquireMulti() {
+    {
+        std::lock_guard<std::mutex> lock(poolMtx);
+        if (!multis.empty()) { void* m = multis.back(); multis.pop_back(); return m; }
+    }
+    return curl_multi_init();
+}
+
+void HttpClient::ReleaseMulti(void* m) {
+    {
+        std::lock_guard<std::mutex> lock(poolMtx);
+        if (multis.size() < maxIdleMultis) { multis.push_back(m); return; }
+    }
+    curl_multi_cleanup((CURLM*)m);
+}
+
+HttpResponse HttpClient::Perform(const std::string& url, const std::string& etag, time_t since) {
+    requests++;
+    HttpResponse r;
+    CURL* curl = (CURL*)Acquire();
+    if (!curl) return r;
+    curl_slist* headers = etag.empty() ? nullptr : curl_slist_append(nullptr, ("If-None-Match: " + etag).c_str());
+    curl_easy_setopt(curl, CURLOPT_URL,        url.c_str());
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA,  &r.body);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &r);
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+    if (since > 0) { curl_easy_setopt(curl, CURLOPT_TIMECONDITION, (long)CURL_TIMECOND_IFMODSINCE); curl_easy_setopt(curl, CURLOPT_TIMEVALUE, (long)since); }
+    CURLcode res = curl_easy_perform(curl);
+    if (res == CURLE_OK) curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &r.status);
+    long opened = 0;
+    if (curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &opened) == CURLE_OK) connects += opened;
+    // Back to a plain GET for the next borrower
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA,  (void*)nullptr);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, (void*)nullptr);
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, (curl_slist*)nullptr);
+    curl_easy_setopt(curl, CURLOPT_TIMECONDITION, (long)CURL_TIMECOND_NONE);
+    curl_slist_free_all(headers);
+    Release(curl);
+    if (res != CURLE_OK) { r.status = 0; r.body.clear(); }
+    return r;
+}
+
+// Transfers in a multi handle use the multi's connection cache rather than the one of
+// their easy handle; PIPEWAIT lets them multiplex over one HTTP/2 connection where the
+// server offers it instead of each opening their own. Each batch borrows a multi handle
+// of its own from a small pool, so concurrent batches (a navigation next to a prefetch)
+// never wait on each other, and the pooled handles keep their connections between batches.
+void HttpClient::GetMany(const std::vector<std::string>& urls, const std::function<void(size_t, HttpResponse)>& done) {
+    std::call_once(init, [this] { Init(); });
+    if (offline) { for (size_t i = 0; i < urls.size(); i++) done(i, {}); return; }
+    CURLM* m = (CURLM*)AcquireMulti();
+    if (!m) { for (size_t i = 0; i < urls.size(); i++) done(i, Request(urls[i])); return; }
+    std::vector<HttpResponse> responses(urls.size());
+    std::vector<CURL*> handles(urls.size(), nullptr);
+    std::vector<size_t> retry; // Quick transient failures, retried one by one once the batch is done
+    auto started = std::chrono::steady_clock::now();
+    int running = 0;
+    for (size_t i = 0; i < urls.size(); i++) {
+        requests++;
+        CURL* curl = (CURL*)Acquire();
+        if (!curl) { done(i, {}); continue; }
+        curl_easy_setopt(curl, CURLOPT_URL,        urls[i].c_str());
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA,  &responses[i].body);
+        curl_easy_setopt(curl, CURLOPT_HEADERDATA, &responses[i]);
+        curl_easy_setopt(curl, CURLOPT_PIPEWAIT,   1L);
+        if (curl_multi_add_handle(m, curl) != CURLM_OK) { Release(curl); done(i, {}); continue; }
+        handles[i] = curl; running++;
+    }
+    while (running > 0) {
+        int active = 0, left = 0;
+        curl_multi_perform(m, &active);
+        while (CURLMsg* msg = curl_multi_info_read(m, &left)) {
+            if (msg->msg != CURLMSG_DONE) continue;
+            CURL* curl = msg->easy_handle; CURLcode res = msg->data.result;
+            size_t i = std::find(handles.begin(), handles.end(), curl) - handles.begin();
+            HttpResponse& r = responses[i];
+            if (res == CURLE_OK) curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &r.status);
+            long opened = 0;
+            if (curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &opened) == CURLE_OK) connects += opened;
+            curl_multi_remove_handle(m, curl);
+            curl_easy_setopt(curl, CURLOPT_WRITEDATA,  (void*)nullptr);
+            curl_easy_setopt(curl, CURLOPT_HEADERDATA, (void*)nullptr);
+            curl_easy_setopt(curl, CURLOPT_PIPEWAIT,   0L);
+            Release(curl, false); // Its connection stays with the multi handle
+            running--;
+            if (res != CURLE_OK) r = {};
+            Record(r, urls[i]);
+            bool slow = std::chrono::steady_clock::now() - started >= std::chrono::seconds(connectTimeout);
+            if (Transient(r) && maxAttempts > 1 && !offline && !slow) retry.push_back(i);
+            else done(i, std::move(r));
+        }
+        if (running > 0) curl_multi_poll(m, nullptr, 0, 1000, nullptr);
+    }
+    ReleaseMulti(m);
+    if (!retry.empty()) std::this_thread::sleep_for(std::chrono::milliseconds(backoffMs));
+    for (size_t i : retry) { retries++; done(i, Attempt(urls[i], "", 0, 2)); } // The batch was attempt 1
+}
+#endif
+
+HttpClient::~HttpClient() {
+    { std::lock_guard<std::mutex> lock(probeMtx); quitting = true; }
+    probeCv.notify_all();
+    if (prober.joinable()) prober.join();
+    Cleanup();
+}
+
+HttpResponse HttpClient::Request(const std::string& url, const std::string& etag, time_t since) {
+    std::call_once(init, [this] { Init(); });
+    return Attempt(url, etag, since, 1);
+}
+
+HttpResponse HttpClient::Attempt(const std::string& url, const std::string& etag, time_t since, int attempt) {
+    HttpResponse r;
+    for (int wait = backoffMs << (attempt - 1); !offline; attempt++, wait *= 2) {
+        auto started = std::chrono::steady_clock::now();
+        r = Perform(url, etag, since);
+        Record(r, url);
+        // A timeout has already cost a full wait; retrying it would multiply the stall
+        bool slow = std::chrono::steady_clock::now() - started >= std::chrono::seconds(connectTimeout);
+        if (!Transient(r) || attempt >= maxAttempts || offline || slow) break;
+        retries++;
+        thread_local std::minstd_rand rng{std::random_device{}()};
+        std::this_thread::sleep_for(std::chrono::milliseconds(wait / 2 + rng() % (wait / 2 + 1))); // Jitter keeps clients from retrying in step
+    }
+    return r;
+}
+
+void HttpClient::Record(const HttpResponse& r, const std::string& url) {
+    if (!Transient(r)) { failStreak = 0; offline = false; return; } // Any answer proves the server is reachable
+    if (++failStreak < tripAfter || offline.exchange(true)) return;
+    std::lock_guard<std::mutex> lock(probeMtx);
+    probeUrl = url;
+    if (!prober.joinable() && !quitting) prober = std::thread(&HttpClient::ProbeLoop, this);
+    probeCv.notify_all();
+}
+
+// Sleeps until the client goes offline, then retries probeUrl with doubling gaps until
+// something answers or another request gets through first
+void HttpClient::ProbeLoop() {
+    std::unique_lock<std::mutex> lock(probeMtx);
+    int gap = probeMinMs;
+    while (!quitting) {
+        if (!offline) { gap = probeMinMs; probeCv.wait(lock, [this] { return quitting || offline; }); continue; }
+        if (probeCv.wait_for(lock, std::chrono::milliseconds(gap), [this] { return quitting || !offline; })) continue;
+        std::string url = probeUrl;
+        lock.unlock();
+        HttpResponse r = Perform(url, "", 0);
+        lock.lock();
+        if (Transient(r)) gap = std::min(gap * 2, probeMaxMs);
+        else { failStreak = 0; offline = false; }
+    }
+}
+
+HttpStats HttpClient::Stats() const {
+    HttpStats s;
+    s.requests = requests; s.connects = connects; s.retries = retries; s.offline = offline;
+    std::lock_guard<std::mutex> lock(poolMtx);
+    s.pooled = (int)idle.size();
+    return s;
+}
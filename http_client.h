@@ -0,0 +1,75 @@
+#pragma once
+#ifndef RAYBIBLE_HTTP_CLIENT_H
+#define RAYBIBLE_HTTP_CLIENT_H
+
+#include "transport.h"
+#include <condition_variable>
+
+struct HttpStats {
+    long requests = 0;
+    long connects = 0; // New connections opened; requests - connects rode on a kept-alive one
+    int pooled = 0;    // Idle handles waiting for the next request
+    long retries = 0;
+    bool offline = false;
+};
+
+// The live-network Transport: one long-lived client for every request the app makes.
+// Transfers borrow a handle from a small LIFO pool and hand it back, so the connection it
+// holds stays open for the next request to the same host: sequential page turns skip
+// DNS, TCP and TLS setup. All
+// handles share one DNS cache and TLS session cache, so even a handle that has to
+// reconnect resumes the TLS session. Every request offers gzip/deflate, and Request can
+// make it conditional so an unchanged resource costs a bodiless 304. Safe to call from
+// any thread.
+//
+// Failures are bounded: connects and stalled reads time out, transient failures (no
+// response, 429, 5xx) are retried with jittered exponential backoff, and after a run of
+// them in a row the client goes offline. Offline requests fail at once, without touching
+// the network, while a background probe retries the last URL with growing gaps until it
+// gets through.
+class HttpClient : public Transport {
+public:
+    ~HttpClient();
+    HttpResponse Request(const std::string& url, const std::string& etag = "", time_t since = 0) override;
+    // Runs every GET at once; batches from different threads run side by side
+    void GetMany(const std::vector<std::string>& urls, const std::function<void(size_t, HttpResponse)>& done) override;
+    HttpStats Stats() const;
+    bool Offline() const override { return offline; }
+
+private:
+    void* share = nullptr;     // CURLSH* (curl) or the HINTERNET session (WinINet)
+    std::vector<void*> multis; // Idle CURLM* handles for GetMany, kept so their connections outlive a batch
+    std::vector<void*> idle;   // Pooled CURL* handles, most recently used last
+    mutable std::mutex poolMtx; // Guards idle and multis
+    std::mutex shareLocks[8]; // One per curl_lock_data kind
+    std::once_flag init;
+    std::atomic<long> requests{0}, connects{0}, retries{0};
+    size_t maxIdle = 8, maxIdleMultis = 4;
+
+    // Fetch policy
+    long connectTimeout = 4, stallTimeout = 10, totalTimeout = 30; // Seconds
+    int maxAttempts = 3, backoffMs = 250; // The wait doubles after each failed attempt
+    int tripAfter = 3;                    // Failed attempts in a row before going offline
+    int probeMinMs = 2000, probeMaxMs = 60000;
+    std::atomic<int> failStreak{0};
+    std::atomic<bool> offline{false}, quitting{false};
+    std::string probeUrl;
+    std::mutex probeMtx; // Guards probeUrl and the prober's sleep
+    std::condition_variable probeCv;
+    std::thread prober;
+
+    void Init();
+    void Cleanup(); // Platform handles, once the prober has stopped
+    HttpResponse Attempt(const std::string& url, const std::string& etag, time_t since, int attempt); // Attempts `attempt`..maxAttempts
+    HttpResponse Perform(const std::string& url, const std::string& etag, time_t since); // One attempt
+    void Record(const HttpResponse& r, const std::string& url); // Feeds the breaker
+    void ProbeLoop();
+    void* Acquire();
+    void Release(void* h, bool connected = true); // Handles without a connection of their own go to the back of the line
+    void* AcquireMulti(); // One per batch in flight, so a background batch never holds up a navigation's
+    void ReleaseMulti(void* m);
+};
+
+extern HttpClient g_http;
+
+#endif // RAYBIBLE_HTTP_CLIENT_H
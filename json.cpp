@@ -0,0 +1,134 @@
+#include "json.h"
+#include "simd_scan.h"
+#include <cstring>
+
+static int Hex4(std::string_view s, size_t p) {
+    if (p + 4 > s.size()) return -1;
+    int v = 0;
+    for (size_t i = p; i < p + 4; i++) {
+        char c = s[i];
+        v <<= 4;
+        if (c >= '0' && c <= '9') v |= c - '0';
+        else if (c >= 'a' && c <= 'f') v |= c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') v |= c - 'A' + 10;
+        else return -1;
+    }
+    return v;
+}
+
+static void AppendUtf8(std::string& out, unsigned cp) {
+    if (cp <= 0x7F) out += (char)cp;
+    else if (cp <= 0x7FF) { out += (char)(0xC0 | (cp >> 6)); out += (char)(0x80 | (cp & 0x3F)); }
+    else if (cp <= 0xFFFF) { out += (char)(0xE0 | (cp >> 12)); out += (char)(0x80 | ((cp >> 6) & 0x3F)); out += (char)(0x80 | (cp & 0x3F)); }
+    else { out += (char)(0xF0 | (cp >> 18)); out += (char)(0x80 | ((cp >> 12) & 0x3F)); out += (char)(0x80 | ((cp >> 6) & 0x3F)); out += (char)(0x80 | (cp & 0x3F)); }
+}
+
+JsonReader::JsonReader(std::string_view d) : doc(d) { JsonStructuralIndex(doc, index); }
+
+// open/close are the quote positions from the index, so the end is already known; only
+// strings that contain a backslash are decoded.
+bool JsonReader::ReadString(size_t open, size_t close) {
+    std::string_view s = doc.substr(open + 1, close - open - 1);
+    size_t p = s.find('\\');
+    if (p == std::string_view::npos) { str = s; escaped = false; return true; }
+
+    scratch.assign(s.data(), p);
+    while (p < s.size()) {
+        if (s[p] != '\\') {
+            size_t run = s.find('\\', p);
+            if (run == std::string_view::npos) run = s.size();
+            scratch.append(s.data() + p, run - p);
+            p = run;
+            continue;
+        }
+        if (++p >= s.size()) return false;
+        switch (s[p]) {
+            case '"': scratch += '"'; break;
+            case '\\': scratch += '\\'; break;
+            case '/': scratch += '/'; break;
+            case 'b': scratch += '\b'; break;
+            case 'f': scratch += '\f'; break;
+            case 'n': scratch += '\n'; break;
+            case 'r': scratch += '\r'; break;
+            case 't': scratch += '\t'; break;
+            case 'u': {
+                int hi = Hex4(s, p + 1);
+                if (hi < 0) return false;
+                p += 4;
+                unsigned cp = (unsigned)hi;
+                if (hi >= 0xD800 && hi <= 0xDBFF) {
+                    // High surrogate: combine with the low half that should follow
+                    int lo = p + 2 < s.size() && s[p + 1] == '\\' && s[p + 2] == 'u' ? Hex4(s, p + 3) : -1;
+                    if (lo >= 0xDC00 && lo <= 0xDFFF) { cp = 0x10000 + (((unsigned)hi - 0xD800) << 10) + ((unsigned)lo - 0xDC00); p += 6; }
+                    else cp = 0xFFFD;
+                } else if (hi >= 0xDC00 && hi <= 0xDFFF) cp = 0xFFFD; // Lone low surrogate
+                AppendUtf8(scratch, cp);
+                break;
+            }
+            default: scratch += '\\'; scratch += s[p]; break; // Kept verbatim, as older cache files wrote them
+        }
+        p++;
+    }
+    str = scratch; escaped = true;
+    return true;
+}
+
+JsonReader::Token JsonReader::Next() {
+    if (tok == Error || tok == End) return tok;
+    str = {}; escaped = false;
+    while (next < index.size()) {
+        size_t pos = index[next++];
+        char c = doc[pos];
+        switch (c) {
+            case ',': expectKey = !stack.empty() && stack.back() == '{'; continue;
+            case ':': expectKey = false; continue;
+            case '{': stack.push_back('{'); expectKey = true; return tok = ObjectBegin;
+            case '[': stack.push_back('['); expectKey = false; return tok = ArrayBegin;
+            case '}': case ']': {
+                char open = c == '}' ? '{' : '[';
+                if (stack.empty() || stack.back() != open) return tok = Error;
+                stack.pop_back(); expectKey = false;
+                return tok = c == '}' ? ObjectEnd : ArrayEnd;
+            }
+            case '"': {
+                bool key = expectKey;
+                if (next >= index.size() || doc[index[next]] != '"' || !ReadString(pos, index[next])) return tok = Error; // Unterminated
+                next++;
+                expectKey = false;
+                return tok = key ? Key : String;
+            }
+            case 't': case 'f': case 'n': {
+                const char* lit = c == 't' ? "true" : c == 'f' ? "false" : "null";
+                size_t n = strlen(lit);
+                if (doc.compare(pos, n, lit) != 0) return tok = Error;
+                str = doc.substr(pos, n);
+                return tok = c == 'n' ? Null : Bool;
+            }
+            default: {
+                size_t p = pos;
+                while (p < doc.size() && (doc[p] == '-' || doc[p] == '+' || doc[p] == '.' || doc[p] == 'e' || doc[p] == 'E' || (doc[p] >= '0' && doc[p] <= '9'))) p++;
+                if (p == pos) return tok = Error;
+                str = doc.substr(pos, p - pos);
+                return tok = Number;
+            }
+        }
+    }
+    return tok = stack.empty() ? End : Error; // Truncated documents end inside a bracket
+}
+
+long long JsonReader::Int() const {
+    if (tok != Number) return 0;
+    size_t i = 0; bool neg = false;
+    if (i < str.size() && (str[i] == '-' || str[i] == '+')) neg = str[i++] == '-';
+    long long v = 0;
+    for (; i < str.size() && str[i] >= '0' && str[i] <= '9'; i++) v = v * 10 + (str[i] - '0');
+    return neg ? -v : v;
+}
+
+bool JsonReader::SkipValue() {
+    if (tok == ObjectBegin || tok == ArrayBegin) {
+        size_t depth = stack.size();
+        while (stack.size() >= depth && Next() != Error && tok != End) {}
+    }
+    return tok != Error;
+}
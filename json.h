@@ -0,0 +1,42 @@
+#pragma once
+#ifndef RAYBIBLE_JSON_H
+#define RAYBIBLE_JSON_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+// Pull tokenizer over a JSON document, one token per Next(). The constructor builds the
+// structural index in one vectorized pass (see simd_scan.h); tokens then hop from one
+// index entry to the next, so string contents and whitespace are never walked bytewise.
+// Strings without escapes are views into the document; escaped ones (including \uXXXX
+// surrogate pairs) are decoded into a scratch buffer that the next token reuses.
+// Separators are not validated and unknown escapes are kept as written, but brackets
+// must nest and strings must terminate.
+class JsonReader {
+public:
+    enum Token { None, ObjectBegin, ObjectEnd, ArrayBegin, ArrayEnd, Key, String, Number, Bool, Null, End, Error };
+
+    explicit JsonReader(std::string_view doc);
+    Token Next(); // Error and End are sticky
+    Token Tok() const { return tok; }
+    std::string_view Str() const { return str; } // Key/String text, Number or Bool literal; valid until Next()
+    bool Escaped() const { return escaped; } // Str() lives in the scratch buffer rather than the document
+    long long Int() const; // Number as an integer, fraction dropped; 0 for other tokens
+    bool SkipValue(); // Consumes the rest of the current value: a whole object/array if it just began
+    int Depth() const { return (int)stack.size(); }
+
+private:
+    std::string_view doc;
+    std::vector<uint32_t> index;
+    size_t next = 0; // Next index entry
+    Token tok = None;
+    std::string_view str;
+    std::string scratch;
+    std::vector<char> stack; // Open brackets
+    bool expectKey = false, escaped = false;
+    bool ReadString(size_t open, size_t close);
+};
+
+#endif // RAYBIBLE_JSON_H
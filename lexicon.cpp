@@ -0,0 +1,176 @@
+#include "lexicon.h"
+#include "managers.h"
+#include "transport.h"
+#include "json.h"
+#include "utils.h"
+#include "markup.h"
+#include <sstream>
+#include <fstream>
+#include <chrono>
+
+LexiconStore g_lexicon;
+
+std::string StrongsKey(int bookIdx, uint32_t number) {
+    return (bookIdx < 39 ? "H" : "G") + std::to_string(number);
+}
+
+std::string DictionaryURL(const std::string& key) {
+    return g_settings.apiBase + "/dictionary-definition/BDBT/" + key + "/";
+}
+
+// First entry of the returned array
+LexiconStore::Result ParseDefinition(const std::string& resp, StrongsDef& out) {
+    JsonReader j(resp);
+    if (j.Next() != JsonReader::ArrayBegin) return LexiconStore::Result::Failed;
+    if (j.Next() != JsonReader::ObjectBegin) return LexiconStore::Result::NotFound;
+    while (j.Next() == JsonReader::Key) {
+        std::string_view key = j.Str();
+        std::string* dst = key == "lexeme" ? &out.lexeme : key == "transliteration" ? &out.transliteration :
+                           key == "pronunciation" ? &out.pronunciation : key == "definition" ? &out.definition :
+                           key == "short_definition" ? &out.shortDef : nullptr;
+        j.Next();
+        if (!dst) { j.SkipValue(); continue; }
+        if (j.Tok() == JsonReader::String) dst->assign(j.Str()); else dst->clear();
+        if (dst == &out.definition) *dst = StripTags(*dst);
+    }
+    if (j.Tok() != JsonReader::ObjectEnd) return LexiconStore::Result::Failed;
+    out.active = true;
+    return LexiconStore::Result::Found;
+}
+
+static LexiconStore::Result FromResponse(const HttpResponse& r, StrongsDef& out) {
+    if (r.status == 404) return LexiconStore::Result::NotFound;
+    if (r.status != 200) return LexiconStore::Result::Failed;
+    return ParseDefinition(r.body, out);
+}
+
+// --- Store ---
+
+LexiconStore::LexiconStore() { file = "lexicon.txt"; Load(); }
+LexiconStore::~LexiconStore() { Stop(); }
+
+// number|lexeme|transliteration|pronunciation|shortDef|definition, newlines escaped; the
+// definition comes last so a '|' in it needs no escaping
+static std::string EntryLine(const std::string& key, const StrongsDef& d) {
+    auto field = [](const std::string& s) { return ReplaceAll(ReplaceAll(s, "|", "/"), "\n", " "); };
+    return key + "|" + field(d.lexeme) + "|" + field(d.transliteration) + "|" + field(d.pronunciation) + "|" + field(d.shortDef) + "|" + ReplaceAll(d.definition, "\n", "\\n") + "\n";
+}
+
+void LexiconStore::Load() {
+    std::string c = ReadFile(file);
+    if (c.empty()) return;
+    std::istringstream iss(c); std::string ln;
+    size_t lines = 0;
+    while (std::getline(iss, ln)) {
+        lines++;
+        std::istringstream ls(ln); StrongsDef d;
+        std::getline(ls, d.number, '|');
+        std::getline(ls, d.lexeme, '|');
+        std::getline(ls, d.transliteration, '|');
+        std::getline(ls, d.pronunciation, '|');
+        std::getline(ls, d.shortDef, '|');
+        std::getline(ls, d.definition);
+        if (d.number.empty()) continue;
+        d.definition = ReplaceAll(d.definition, "\\n", "\n");
+        d.active = true;
+        std::string key = d.number;
+        entries[key] = std::move(d); // A later line for the same number wins
+    }
+    // Files written before Store skipped known numbers can hold the same one many times over
+    if (lines > entries.size() + entries.size() / 2 + 64) {
+        std::string out;
+        for (const auto& kv : entries) out += EntryLine(kv.first, kv.second);
+        WriteFileAtomic(file, out);
+    }
+}
+
+void LexiconStore::Store(const std::string& key, StrongsDef&& d) {
+    if (entries.count(key)) return; // Fetched twice at once; the file already has it
+    d.number = key;
+    std::ofstream f(file, std::ios::app | std::ios::binary);
+    if (f.is_open()) f << EntryLine(key, d);
+    entries[key] = std::move(d);
+}
+
+bool LexiconStore::Get(const std::string& key, StrongsDef& out) const {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = entries.find(key);
+    if (it == entries.end()) return false;
+    out = it->second;
+    return true;
+}
+
+LexiconStore::Result LexiconStore::Fetch(const std::string& key, StrongsDef& out) {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = entries.find(key);
+        if (it != entries.end()) { out = it->second; return Result::Found; }
+        if (missing.count(key)) return Result::NotFound;
+    }
+    StrongsDef d;
+    Result r = FromResponse(g_transport->Request(DictionaryURL(key)), d);
+    if (r == Result::Failed) return r;
+    fetched++;
+    std::lock_guard<std::mutex> lock(mtx);
+    if (r == Result::NotFound) { missing.insert(key); return r; }
+    out = d;
+    Store(key, std::move(d));
+    return r;
+}
+
+void LexiconStore::Prefetch(const std::vector<std::string>& keys) {
+    std::lock_guard<std::mutex> lock(mtx);
+    if (quit) return;
+    size_t before = queue.size();
+    for (const auto& k : keys)
+        if (!entries.count(k) && !missing.count(k) && pending.insert(k).second) queue.push_back(k);
+    if (queue.size() == before) return;
+    if (!prefetcher.joinable()) prefetcher = std::thread(&LexiconStore::PrefetchLoop, this);
+    wake.notify_one();
+}
+
+void LexiconStore::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        quit = true;
+        queue.clear(); pending.clear();
+    }
+    wake.notify_all();
+    if (prefetcher.joinable()) prefetcher.join();
+}
+
+void LexiconStore::PrefetchLoop() {
+    std::unique_lock<std::mutex> lock(mtx);
+    while (!quit) {
+        wake.wait(lock, [this] { return quit || !queue.empty(); });
+        if (quit) break;
+        if (g_transport->Offline()) { wake.wait_for(lock, std::chrono::milliseconds(500)); continue; } // Keep the queue until the connection is back
+        std::vector<std::string> keys, urls;
+        while (!queue.empty() && keys.size() < batchSize) {
+            keys.push_back(queue.front()); queue.pop_front();
+            if (entries.count(keys.back())) { pending.erase(keys.back()); keys.pop_back(); continue; } // A click fetched it first
+            urls.push_back(DictionaryURL(keys.back()));
+        }
+        if (keys.empty()) continue;
+        auto started = std::chrono::steady_clock::now();
+        lock.unlock();
+        std::vector<std::pair<Result, StrongsDef>> got(keys.size());
+        g_transport->GetMany(urls, [&](size_t i, HttpResponse r) { got[i].first = FromResponse(r, got[i].second); });
+        lock.lock();
+        for (size_t i = 0; i < keys.size(); i++) {
+            pending.erase(keys[i]);
+            if (got[i].first == Result::Failed) continue; // Left for the next Prefetch of this chapter
+            fetched++;
+            if (got[i].first == Result::NotFound) missing.insert(keys[i]);
+            else Store(keys[i], std::move(got[i].second));
+        }
+        wake.wait_until(lock, started + std::chrono::milliseconds(batchGapMs), [this] { return quit.load(); });
+    }
+}
+
+LexiconStats LexiconStore::Stats() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    LexiconStats s;
+    s.entries = (int)entries.size(); s.queued = (int)queue.size(); s.fetched = fetched;
+    return s;
+}
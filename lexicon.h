@@ -0,0 +1,62 @@
+#pragma once
+#ifndef RAYBIBLE_LEXICON_H
+#define RAYBIBLE_LEXICON_H
+
+#include "raybible.h"
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+struct LexiconStats {
+    int entries = 0; // Definitions held (all of them also on disk)
+    int queued = 0;  // Waiting for the prefetcher
+    long fetched = 0;
+};
+
+// Strong's definitions keyed by number with its testament prefix ("H7225", "G26"). Every
+// definition fetched is kept in memory and appended to lexicon.txt once, so a word looked
+// up once opens instantly and offline from then on; Load rewrites a file that holds many
+// more lines than numbers. Prefetch hands numbers to a background thread that fetches the
+// missing ones in small paced batches.
+class LexiconStore {
+    std::unordered_map<std::string, StrongsDef> entries;
+    std::unordered_set<std::string> missing; // Not in the dictionary; remembered for this run only
+    std::unordered_set<std::string> pending; // Queued or in flight
+    std::deque<std::string> queue;
+    std::string file;
+    mutable std::mutex mtx;
+    std::condition_variable wake;
+    std::thread prefetcher;
+    std::atomic<bool> quit{false};
+    std::atomic<long> fetched{0};
+    size_t batchSize = 8;
+    int batchGapMs = 1000; // Paces prefetch to about batchSize requests a second
+
+    void Load();
+    void Store(const std::string& key, StrongsDef&& d); // Memory and disk unless already known; caller holds mtx
+    void PrefetchLoop();
+public:
+    enum class Result { Found, NotFound, Failed };
+
+    LexiconStore();
+    ~LexiconStore();
+    bool Get(const std::string& key, StrongsDef& out) const; // Local only
+    Result Fetch(const std::string& key, StrongsDef& out);  // Local, else the network
+    void Prefetch(const std::vector<std::string>& keys);    // Queues those not known yet
+    void Stop(); // Drops the queue and waits for the prefetcher
+    LexiconStats Stats() const;
+};
+
+std::string StrongsKey(int bookIdx, uint32_t number); // "H" for the Old Testament, "G" for the New
+std::string DictionaryURL(const std::string& key);
+LexiconStore::Result ParseDefinition(const std::string& resp, StrongsDef& out);
+
+extern LexiconStore g_lexicon;
+
+#endif // RAYBIBLE_LEXICON_H
@@ -60,7 +60,7 @@ int main() {
             if (ctrl && IsKeyPressed(KEY_B)) { state.bookMode = !state.bookMode; if (state.bookMode) state.needsPageRebuild = true; state.SaveSettings(); }
             if (IsKeyPressed(KEY_Z)) { state.zenMode = !state.zenMode; state.SaveSettings(); }
             if (IsKeyPressed(KEY_S)) { state.showSidebar = !state.showSidebar; state.SaveSettings(); }
-            if (IsKeyPressed(KEY_T)) { state.studyMode = !state.studyMode; if (state.bookMode) state.needsPageRebuild = true; state.SaveSettings(); }
+            if (IsKeyPressed(KEY_T)) { state.studyMode = !state.studyMode; state.needsLexicon = true; if (state.bookMode) state.needsPageRebuild = true; state.SaveSettings(); }
             
             if (ctrl && IsKeyPressed(KEY_F)) { bool val = !state.showSearch; closeAllPanels(state); state.showSearch = val; if (!state.showSearch) { memset(state.searchBuf, 0, sizeof(state.searchBuf)); state.searchResults.clear(); } }
             if (ctrl && IsKeyPressed(KEY_J)) { bool val = !state.showJump; closeAllPanels(state); state.showJump = val; if (!state.showJump) memset(state.jumpBuf, 0, sizeof(state.jumpBuf)); }
@@ -92,15 +92,15 @@ int main() {
             if (IsKeyPressed(KEY_ENTER)) { int nb, nc, nv; if (ParseReference(state.jumpBuf, nb, nc, nv)) { state.curBookIdx = nb; state.curChNum = nc; state.targetScrollY = 0; state.scrollY = 0; state.scrollToVerse = nv; state.InitBuffer(); state.showJump = false; memset(state.jumpBuf, 0, sizeof(state.jumpBuf)); } }
         } else if (state.showSearch) {
             if (IsKeyPressed(KEY_BACKSPACE)) { size_t len = strlen(state.searchBuf); if (len > 0) state.searchBuf[len - 1] = 0; }
-            if (strlen(state.searchBuf) > 0) { state.searchResults = SearchVerses(state.buf, state.searchBuf, state.searchCS); } else state.searchResults.clear();
+            if (strlen(state.searchBuf) > 0) { state.searchResults = SearchVerses(state.view->buf, state.searchBuf, state.searchCS); } else state.searchResults.clear();
         } else if (state.showGlobalSearch) {
             if (IsKeyPressed(KEY_BACKSPACE)) { size_t len = strlen(state.gSearchBuf); if (len > 0) state.gSearchBuf[len - 1] = 0; }
             if (IsKeyPressed(KEY_ENTER) && !state.gSearchActive) state.StartGlobalSearch();
         } else if (state.isEditingNote) {
             if (IsKeyPressed(KEY_BACKSPACE)) { size_t len = strlen(state.noteBuf); if (len > 0) state.noteBuf[len - 1] = 0; }
             if (IsKeyPressed(KEY_ENTER)) {
-                if (!state.buf.empty() && state.lastSelectedVerse != -1) {
-                    std::string vText; int ci = state.scrollChapterIdx; if (ci >= 0 && ci < (int)state.buf.size()) { for (const auto& v : state.buf[ci].verses) { if (v.number == state.lastSelectedVerse) { vText = v.text; break; } } g_study.SetNote(state.buf[ci].book, state.buf[ci].chapter, state.lastSelectedVerse, state.trans, state.noteBuf, vText); }
+                if (!state.view->buf.empty() && state.lastSelectedVerse != -1) {
+                    std::string vText; int ci = state.scrollChapterIdx; if (ci >= 0 && ci < (int)state.view->buf.size()) { for (const auto& v : state.view->buf[ci]->verses) { if (v.number == state.lastSelectedVerse) { vText = v.text; break; } } g_study.SetNote(state.view->buf[ci]->book, state.view->buf[ci]->chapter, state.lastSelectedVerse, state.trans, state.noteBuf, vText); }
                 }
                 state.isEditingNote = false;
             }
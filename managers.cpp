@@ -1,231 +1,674 @@
 #include "managers.h"
 #include "utils.h"
+#include "markup.h"
+#include "codec.h"
+#include "json.h"
 #include <fstream>
 #include <sstream>
 #include <algorithm>
-#include <sys/stat.h>
-
-#ifdef _WIN32
-    #include <windows.h>
-#else
-    #include <dirent.h>
-#endif
+#include <cstdio>
+#include <ctime>
+#include <chrono>
 
 CacheManager g_cache;
+ChapterStore g_chapters;
 StudyManager g_study;
 HistoryManager g_hist;
 SettingsManager g_settings;
 
 // --- CacheManager ---
-CacheManager::CacheManager() { base = "cache"; MakeDir(base); }
+CacheManager::CacheManager() { base = "cache"; MakeDir(base); dict.Load(DictPath()); }
+CacheManager::~CacheManager() {
+    { auto lock = WriteLock(); jquit = true; }
+    jcv.notify_one();
+    if (janitor.joinable()) janitor.join();
+    for (auto& kv : stores) if (kv.second) FlushManifest(kv.first, *kv.second, 1);
+}
 std::string CacheManager::Path(const std::string& t, const std::string& b, int c) const { return base + "/" + t + "/" + b + "/" + std::to_string(c) + ".json"; }
 std::string CacheManager::TDir(const std::string& t) const { return base + "/" + t; }
 std::string CacheManager::BDir(const std::string& t, const std::string& b) const { return base + "/" + t + "/" + b; }
+std::string CacheManager::ArchivePath(const std::string& t) const { return base + "/" + t + ".pack"; }
+std::string CacheManager::ManifestPath(const std::string& t) const { return base + "/" + t + ".manifest"; }
+std::string CacheManager::DictPath() const { return base + "/shared.dict"; }
+
+// Compresses a record for storage. Until a dictionary exists, plain records are kept as
+// training samples; once enough have been seen Save trains one dictionary, which is then
+// reused for every later record of every translation.
+std::string CacheManager::Pack(const std::string& rec) const {
+    if (!compress) return rec;
+    if (!dict.id && !training) { dictSamples.push_back(rec); sampleBytes += rec.size(); }
+    return CompressRecord(rec, dict);
+}
+
+// Training on up to 1 MiB of samples takes a while, so it runs on a snapshot of them with
+// the lock released. The result is swapped in under the lock unless the cache was cleared
+// meanwhile; records saved until then are stored without a dictionary.
+void CacheManager::TrainWhenReady(std::unique_lock<std::shared_mutex>& lock) const {
+    if (dict.id || training || (dictSamples.size() < 64 && sampleBytes < (1u << 20))) return;
+    std::vector<std::string> samples;
+    samples.swap(dictSamples); sampleBytes = 0;
+    uint64_t epoch = dictEpoch;
+    training = true;
+    lock.unlock();
+    std::string trained = TrainDictionary(samples, 64u << 10);
+    lock = WriteLock();
+    if (epoch != dictEpoch) return; // Cleared meanwhile, which also ended this round
+    training = false;
+    dict.Set(std::move(trained));
+    if (dict.id) dict.Save(DictPath());
+}
+
+// Chapter as stored by the old JSON cache (text already stripped at fetch time). Files
+// cut short by a crash mid-write fail like malformed ones, rather than keeping the verses
+// read so far, so the chapter is refetched instead of cached incomplete.
+static bool ParseLegacyJson(std::string_view json, Chapter& ch) {
+    JsonReader j(json);
+    if (j.Next() != JsonReader::ObjectBegin) return false;
+    std::string rawOwned, textOwned;
+    while (j.Next() == JsonReader::Key) {
+        std::string_view key = j.Str();
+        std::string* dst = key == "book" ? &ch.book : key == "translation" ? &ch.translation : nullptr;
+        bool isChapter = key == "chapter", isFetched = key == "fetchedAt", isVerses = key == "verses";
+        j.Next();
+        if (dst) dst->assign(j.Str());
+        else if (isChapter) ch.chapter = (int)j.Int();
+        else if (isFetched) ch.fetchedAt = (time_t)j.Int();
+        else if (isVerses && j.Tok() == JsonReader::ArrayBegin) {
+            while (j.Next() == JsonReader::ObjectBegin) {
+                int number = 0; std::string_view raw, text;
+                while (j.Next() == JsonReader::Key) {
+                    std::string_view k = j.Str();
+                    std::string_view* dst = k == "rawText" ? &raw : k == "text" ? &text : nullptr;
+                    bool isNumber = k == "number";
+                    j.Next();
+                    if (isNumber) number = (int)j.Int();
+                    else if (dst && j.Tok() == JsonReader::String) *dst = !j.Escaped() ? j.Str() : std::string_view((dst == &raw ? rawOwned : textOwned).assign(j.Str()));
+                    else if (!j.SkipValue()) return false;
+                }
+                if (j.Tok() != JsonReader::ObjectEnd) return false;
+                if (!raw.empty() && ch.AddTaggedVerse(number, raw)) continue;
+                std::string clean = StripTags(text);
+                if (!clean.empty()) ch.AddVerse(number, clean);
+            }
+            if (j.Tok() != JsonReader::ArrayEnd) return false;
+        }
+        else if (!j.SkipValue()) return false;
+    }
+    if (j.Tok() != JsonReader::ObjectEnd || ch.verses.empty()) return false;
+    ch.Fit();
+    return true;
+}
+
+CacheManager::Store* CacheManager::Find(const std::string& t, bool create) const {
+    auto it = stores.find(t);
+    if (it != stores.end() && (it->second || !create)) return it->second.get(); // Null entry = known absent
+    bool legacy = DirExists(TDir(t));
+    auto st = std::make_unique<Store>(ArchivePath(t), ++nextSerial);
+    if (!st->archive.Open(create || legacy)) { stores[t] = nullptr; return nullptr; }
+    if (legacy) MigrateLegacy(t, st->archive);
+    Reconcile(t, *st);
+    return (stores[t] = std::move(st)).get();
+}
+
+// A chapter whose record could not be written keeps its JSON file, and with it the legacy
+// tree, so the migration is tried again the next time the archive is opened
+void CacheManager::MigrateLegacy(const std::string& t, ChapterArchive& a) const {
+    for (int b = 0; b < (int)BIBLE_BOOKS.size(); b++) {
+        std::string bd = BDir(t, BIBLE_BOOKS[b].abbrev);
+        if (!DirExists(bd)) continue;
+        for (int c = 1; c <= BIBLE_BOOKS[b].chapters; c++) {
+            std::string p = Path(t, BIBLE_BOOKS[b].abbrev, c);
+            if (!FileExists(p)) continue;
+            std::string json = ReadFile(p);
+            Chapter ch;
+            if (!a.Has(ChapterSlot(b, c)) && ParseLegacyJson(json, ch) && !a.Write(ChapterSlot(b, c), Pack(EncodeChapterRecord(ch)))) continue;
+            remove(p.c_str());
+        }
+        RemoveDir(bd); // Fails, as it should, while a chapter is left in it
+    }
+    RemoveDir(TDir(t));
+}
 
-bool CacheManager::Has(const std::string& t, const std::string& b, int c) const { return FileExists(Path(t, b, c)); }
+// Brings the manifest in line with the archive table. A missing or corrupt manifest is
+// rebuilt from the records; otherwise only slots whose size disagrees are re-read.
+// JSON records from the first archive format are converted, corrupt ones dropped.
+void CacheManager::Reconcile(const std::string& t, Store& st) const {
+    if (!st.manifest.Load(ManifestPath(t))) st.manifest.Reset();
+    std::string scratch;
+    for (int slot = 0; slot < TotalChapters(); slot++) {
+        std::string_view stored = st.archive.Read(slot), rec;
+        if (!stored.empty() && stored[0] == '{') {
+            Chapter ch;
+            if (ParseLegacyJson(stored, ch)) st.archive.Write(slot, Pack(EncodeChapterRecord(ch)));
+            else st.archive.Erase(slot); // Left empty, so the chapter is fetched again
+            stored = st.archive.Read(slot);
+        }
+        if (stored.size() == st.manifest.Get(slot).bytes) continue;
+        uint32_t verses = 0; int64_t fetchedAt = 0;
+        if (!stored.empty() && ExpandRecord(stored, dict, scratch, rec) && PeekChapterRecord(rec, verses, fetchedAt)) { st.manifest.Set(slot, verses, (uint32_t)stored.size(), (uint32_t)rec.size(), fetchedAt); continue; }
+        if (!stored.empty()) st.archive.Erase(slot);
+        st.manifest.Clear(slot);
+    }
+    FlushManifest(t, st, 1);
+}
+
+void CacheManager::FlushManifest(const std::string& t, Store& st, int threshold) const {
+    if (st.manifest.Pending() >= threshold) st.manifest.Save(ManifestPath(t));
+}
+
+// Writers hold `gate` while they wait for mtx, so a steady stream of loads cannot starve a
+// save: new readers queue on the gate behind it instead of slipping into the shared lock.
+std::shared_lock<std::shared_mutex> CacheManager::ReadLock() const {
+    bool waited = false;
+    { std::unique_lock<std::mutex> g(gate, std::try_to_lock); if (!g.owns_lock()) { waited = true; g.lock(); } }
+    std::shared_lock<std::shared_mutex> lock(mtx, std::try_to_lock);
+    if (!lock.owns_lock()) { waited = true; lock.lock(); }
+    if (waited) readWaits++;
+    lockCount++;
+    return lock;
+}
+
+std::unique_lock<std::shared_mutex> CacheManager::WriteLock() const {
+    bool waited = false;
+    std::unique_lock<std::mutex> g(gate, std::try_to_lock);
+    if (!g.owns_lock()) { waited = true; g.lock(); }
+    std::unique_lock<std::shared_mutex> lock(mtx, std::try_to_lock);
+    if (!lock.owns_lock()) { waited = true; lock.lock(); }
+    if (waited) writeWaits++;
+    lockCount++;
+    return lock;
+}
+
+CacheManager::Store* CacheManager::Lookup(const std::string& t) const {
+    auto it = stores.find(t);
+    return it == stores.end() ? nullptr : it->second.get();
+}
+
+void CacheManager::OpenStore(const std::string& t) const {
+    { auto lock = ReadLock(); if (stores.count(t)) return; }
+    auto lock = WriteLock();
+    Find(t, false);
+}
+
+bool CacheManager::Has(const std::string& t, const std::string& b, int c) const {
+    OpenStore(t);
+    auto lock = ReadLock();
+    Store* st = Lookup(t);
+    int slot = ChapterSlot(BookIndexOf(b), c);
+    return st && slot >= 0 && st->manifest.Get(slot).bytes > 0;
+}
 
 Chapter CacheManager::Load(const std::string& t, const std::string& b, int cn) const {
-    std::lock_guard<std::mutex> lock(mtx);
-    std::string json = ReadFile(Path(t, b, cn));
+    OpenStore(t);
+    auto lock = ReadLock();
     Chapter ch{};
-    ch.book = JStr(json, "book");
-    ch.chapter = JInt(json, "chapter");
-    ch.translation = JStr(json, "translation");
-    ch.fetchedAt = (time_t)JLong(json, "fetchedAt");
+    Store* st = Lookup(t);
+    if (!st) return ch;
+    // A record that fails validation comes back with isLoaded == false so the caller refetches
     ch.fromCache = true;
-    ch.isLoaded = true;
-    for (const auto& v : JArr(json, "verses")) {
-        Verse vr;
-        vr.number = JInt(v, "number");
-        vr.rawText = JStr(v, "rawText");
-        vr.text   = StripTags(JStr(v, "text"));
-        if (!vr.text.empty()) ch.verses.push_back(vr);
-    }
+    thread_local std::string scratch; // Keeps its capacity, so expanding a record neither allocates nor clears
+    std::string_view rec;
+    int slot = ChapterSlot(BookIndexOf(b), cn);
+    ch.isLoaded = ExpandRecord(st->archive.Read(slot), dict, scratch, rec) && DecodeChapterRecord(rec, ch);
+    if (ch.isLoaded) { std::lock_guard<std::mutex> tl(st->touchMtx); st->manifest.Touch(slot, (int64_t)time(nullptr)); }
     return ch;
 }
 
 bool CacheManager::Save(const Chapter& ch) const {
-    std::lock_guard<std::mutex> lock(mtx);
-    MakeDir(TDir(ch.translation));
-    std::string ba;
-    for (const auto& bk : BIBLE_BOOKS) {
-        if (ch.book.find(bk.name) != std::string::npos || ch.book.find(bk.abbrev) != std::string::npos) { ba = bk.abbrev; break; }
+    std::string ba = ch.bookAbbrev;
+    if (ba.empty()) {
+        for (const auto& bk : BIBLE_BOOKS) {
+            if (ch.book.find(bk.name) != std::string::npos || ch.book.find(bk.abbrev) != std::string::npos) { ba = bk.abbrev; break; }
+        }
+    }
+    int slot = ChapterSlot(BookIndexOf(ba), ch.chapter);
+    if (slot < 0) return false;
+
+    // Encoding and compression run before the exclusive lock so readers are not held up.
+    // Until the dictionary is trained, or if it was replaced meanwhile, Pack redoes it.
+    std::string rec = EncodeChapterRecord(ch), stored;
+    uint32_t dictId = 0;
+    { auto lock = ReadLock(); if (!compress) stored = rec; else if (dict.id) { stored = CompressRecord(rec, dict); dictId = dict.id; } }
+    auto lock = WriteLock();
+    Store* st = Find(ch.translation, true);
+    if (!st) return false;
+    if (stored.empty() || (dictId && dictId != dict.id)) stored = Pack(rec);
+    if (!st->archive.Write(slot, stored)) return false;
+    st->manifest.Set(slot, (uint32_t)ch.verses.size(), (uint32_t)stored.size(), (uint32_t)rec.size(), (int64_t)ch.fetchedAt);
+    FlushManifest(ch.translation, *st, 16);
+    if (quota && DiskBytes() > quota) { jwake = true; jcv.notify_one(); }
+    TrainWhenReady(lock);
+    return true;
+}
+
+bool CacheManager::Remove(const std::string& t, const std::string& b, int c) {
+    auto lock = WriteLock();
+    Store* st = Find(t, false);
+    int slot = ChapterSlot(BookIndexOf(b), c);
+    if (!st || !st->archive.Erase(slot)) return false;
+    st->manifest.Clear(slot);
+    FlushManifest(t, *st, 1);
+    return true;
+}
+
+void CacheManager::Evict(const std::string& t, int bookIdx) {
+    auto lock = WriteLock();
+    evictions.push_back({t, bookIdx});
+    StartJanitor();
+    jcv.notify_one();
+}
+
+void CacheManager::ClearCache() { Evict("", -1); }
+
+void CacheManager::SetQuota(uint64_t bytes) {
+    auto lock = WriteLock();
+    quota = bytes;
+    StartJanitor();
+    jwake = true;
+    jcv.notify_one();
+}
+
+uint64_t CacheManager::DiskBytes() const {
+    uint64_t n = 0;
+    for (const auto& kv : stores) if (kv.second) n += kv.second->archive.FileBytes();
+    return n;
+}
+
+void CacheManager::StartJanitor() {
+    if (!janitor.joinable()) janitor = std::thread(&CacheManager::JanitorLoop, this);
+}
+
+void CacheManager::JanitorLoop() {
+    auto lock = WriteLock();
+    while (!jquit) {
+        // Besides explicit wake-ups, a periodic pass flushes access times and catches dead space
+        jcv.wait_for(lock, std::chrono::seconds(60), [this] { return jquit || jwake || !evictions.empty(); });
+        if (jquit) break;
+        jwake = false; jbusy = true;
+        std::vector<std::string> dirty;
+        while (!evictions.empty()) {
+            Eviction ev = std::move(evictions.front()); evictions.pop_front();
+            std::string t = RunEviction(ev);
+            if (!t.empty()) dirty.push_back(t);
+        }
+        lock.unlock();
+        bool over = EnforceQuota();
+        lock.lock();
+        std::vector<std::string> names;
+        for (const auto& kv : stores) if (kv.second) names.push_back(kv.first);
+        lock.unlock();
+        for (const auto& t : names) Compact(t, over || std::find(dirty.begin(), dirty.end(), t) != dirty.end());
+        lock.lock();
+        for (auto& kv : stores) if (kv.second) FlushManifest(kv.first, *kv.second, 1);
+        jbusy = false;
     }
-    if (ba.empty()) return false;
-    MakeDir(BDir(ch.translation, ba));
-
-    std::ostringstream j;
-    j << "{\n"
-      << "  \"book\":\"" << ch.book << "\",\n"
-      << "  \"chapter\":" << ch.chapter << ",\n"
-      << "  \"translation\":\"" << ch.translation << "\",\n"
-      << "  \"fetchedAt\":" << ch.fetchedAt << ",\n"
-      << "  \"verses\":[\n";
-    for (size_t i = 0; i < ch.verses.size(); i++) {
-        std::string t = ch.verses[i].text;
-        size_t pos = 0;
-        while ((pos = t.find("\"", pos)) != std::string::npos) { t.replace(pos, 1, "\\\""); pos += 2; }
-        std::string rt = ch.verses[i].rawText;
-        pos = 0;
-        while ((pos = rt.find("\"", pos)) != std::string::npos) { rt.replace(pos, 1, "\\\""); pos += 2; }
-        j << "    {\"number\":" << ch.verses[i].number << ",\"text\":\"" << t << "\",\"rawText\":\"" << rt << "\"}";
-        if (i + 1 < ch.verses.size()) j << ",";
-        j << "\n";
+}
+
+std::string CacheManager::RunEviction(const Eviction& ev) {
+    if (ev.t.empty()) {
+        // Close every archive first so the files can be deleted on every platform
+        stores.clear();
+        RemoveTree(base);
+        MakeDir(base);
+        dict.Set(""); dictSamples.clear(); sampleBytes = 0; training = false; dictEpoch++; // Retrain from whatever gets cached next
+        return "";
     }
-    j << "  ]\n}";
-    return WriteFile(Path(ch.translation, ba, ch.chapter), j.str());
+    if (ev.bookIdx < 0) {
+        stores[ev.t] = nullptr; // Known absent until the next save recreates it
+        remove(ArchivePath(ev.t).c_str()); remove(ManifestPath(ev.t).c_str());
+        RemoveTree(TDir(ev.t));
+        return "";
+    }
+    Store* st = Find(ev.t, false);
+    if (!st || ev.bookIdx >= (int)BIBLE_BOOKS.size()) return "";
+    for (int c = 1; c <= BIBLE_BOOKS[ev.bookIdx].chapters; c++) {
+        int slot = ChapterSlot(ev.bookIdx, c);
+        if (st->archive.Erase(slot)) st->manifest.Clear(slot);
+    }
+    FlushManifest(ev.t, *st, 1);
+    return ev.t;
 }
 
-void CacheManager::ClearCache() {
-    std::lock_guard<std::mutex> lock(mtx);
-#ifdef _WIN32
-    system("rmdir /s /q cache");
-#else
-    system("rm -rf cache");
-#endif
-    MakeDir(base);
+// Evicts least recently read chapters, in small locked batches, until the live data is
+// back under 90% of the quota so the next few saves do not trigger another pass. Returns
+// whether the files were over quota; their dead space is then compacted away.
+bool CacheManager::EnforceQuota() {
+    struct Victim { int64_t lastAccess; std::string t; int slot; uint32_t bytes; };
+    std::vector<Victim> victims;
+    for (const auto& tr : TRANSLATIONS) OpenStore(tr.code);
+    {
+        // Choosing victims only reads, so loads carry on meanwhile
+        auto lock = ReadLock();
+        if (!quota) return false;
+        if (DiskBytes() <= quota) return false;
+        uint64_t live = 0;
+        for (const auto& kv : stores) {
+            if (!kv.second) continue;
+            const CacheManifest& m = kv.second->manifest;
+            live += m.Bytes();
+            std::lock_guard<std::mutex> tl(kv.second->touchMtx);
+            for (int slot = 0; slot < TotalChapters(); slot++) { const auto& e = m.Get(slot); if (e.bytes) victims.push_back({e.lastAccess, kv.first, slot, e.bytes}); }
+        }
+        std::sort(victims.begin(), victims.end(), [](const Victim& a, const Victim& b) { return a.lastAccess < b.lastAccess; });
+        uint64_t target = quota / 10 * 9;
+        size_t n = 0;
+        while (n < victims.size() && live > target) live -= victims[n++].bytes;
+        victims.resize(n);
+    }
+    const size_t BATCH = 32;
+    for (size_t i = 0; i < victims.size(); i += BATCH) {
+        auto lock = WriteLock();
+        for (size_t j = i; j < std::min(i + BATCH, victims.size()); j++) {
+            const Victim& v = victims[j];
+            auto it = stores.find(v.t);
+            if (it == stores.end() || !it->second) continue;
+            Store& st = *it->second;
+            if (st.manifest.Get(v.slot).lastAccess != v.lastAccess) continue; // Read or rewritten since
+            if (st.archive.Erase(v.slot)) { st.manifest.Clear(v.slot); evicted++; }
+        }
+    }
+    return true;
+}
+
+// Rewrites an archive without its dead records once they are worth reclaiming (or always,
+// when forced). The bulk copy runs unlocked; only the catch-up and file swap lock.
+void CacheManager::Compact(const std::string& t, bool force) {
+    std::vector<ChapterArchive::Entry> snap, moved;
+    std::string src, dst;
+    uint64_t serial;
+    {
+        auto lock = ReadLock();
+        auto it = stores.find(t);
+        if (it == stores.end() || !it->second) return;
+        const ChapterArchive& a = it->second->archive;
+        uint64_t dead = a.DeadBytes(), live = a.FileBytes() - dead;
+        if (dead == 0 || (!force && dead < std::max<uint64_t>(1 << 20, live / 4))) return;
+        snap = a.Snapshot(); src = a.FilePath(); dst = src + ".compact"; serial = it->second->serial;
+    }
+    bool ok = ChapterArchive::CompactCopy(src, dst, snap, moved);
+    if (ok) {
+        auto lock = WriteLock();
+        auto it = stores.find(t);
+        ok = it != stores.end() && it->second && it->second->serial == serial && it->second->archive.CompactFinish(dst, snap, moved);
+        if (it != stores.end() && it->second && !it->second->archive.IsOpen()) stores.erase(it); // Reopened on next use
+    }
+    if (!ok) remove(dst.c_str());
 }
 
+void CacheManager::SetCompression(bool on) { auto lock = WriteLock(); compress = on; }
+
 CacheStats CacheManager::Stats() const {
-    std::lock_guard<std::mutex> lock(mtx);
+    for (const auto& tr : TRANSLATIONS) OpenStore(tr.code);
+    auto lock = ReadLock();
     CacheStats s{};
     for (const auto& tr : TRANSLATIONS) {
-        int tc = 0;
-        for (const auto& bk : BIBLE_BOOKS) {
-            std::string bd = BDir(tr.code, bk.abbrev);
-            if (!DirExists(bd)) continue;
-#ifdef _WIN32
-            WIN32_FIND_DATAA fd;
-            HANDLE hf = FindFirstFileA((bd + "\\*").c_str(), &fd);
-            if (hf != INVALID_HANDLE_VALUE) {
-                do {
-                    if (!(fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
-                        std::string fn = fd.cFileName;
-                        if (fn.find(".json") != std::string::npos) {
-                            std::string fp = bd + "/" + fn;
-                            s.totalSize += GetFileSize(fp);
-                            s.totalChapters++; tc++;
-                            s.totalVerses += (int)JArr(ReadFile(fp), "verses").size();
-                        }
-                    }
-                } while (FindNextFileA(hf, &fd));
-                FindClose(hf);
-            }
-#else
-            DIR* d = opendir(bd.c_str());
-            if (!d) continue;
-            struct dirent* e;
-            while ((e = readdir(d))) {
-                if (e->d_type == DT_REG) {
-                    std::string fn = e->d_name;
-                    if (fn.find(".json") != std::string::npos) {
-                        std::string fp = bd + "/" + fn;
-                        s.totalSize += GetFileSize(fp);
-                        s.totalChapters++; tc++;
-                        s.totalVerses += (int)JArr(ReadFile(fp), "verses").size();
-                    }
-                }
-            }
-            closedir(d);
-#endif
+        const Store* st = Lookup(tr.code);
+        int tc = st ? st->manifest.Chapters() : 0;
+        if (st) {
+            s.totalChapters += tc;
+            s.totalVerses += (int)st->manifest.Verses();
+            s.totalSize += (long)st->archive.FileBytes();
+            s.logicalSize += (long)st->manifest.LogicalBytes();
         }
         s.byTranslation[tr.code] = tc;
     }
+    s.quota = (long)quota; s.evicted = evicted; s.evicting = jbusy || !evictions.empty();
+    s.lockCount = lockCount; s.readWaits = readWaits; s.writeWaits = writeWaits;
     return s;
 }
 
+// --- ChapterStore ---
+
+size_t ChapterBytes(const Chapter& ch) {
+    return sizeof(Chapter) + ch.book.capacity() + ch.bookAbbrev.capacity() + ch.translation.capacity() + ch.etag.capacity() + ch.verses.capacity() * sizeof(Verse) + ch.ArenaBytes();
+}
+
+std::string ChapterStore::Key(const std::string& t, int bookIdx, int ch) { return t + ":" + std::to_string(ChapterSlot(bookIdx, ch)); }
+
+ChapterRef ChapterStore::Get(const std::string& t, int bookIdx, int ch) {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = index.find(Key(t, bookIdx, ch));
+    if (it == index.end()) { misses++; return nullptr; }
+    hits++;
+    lru.splice(lru.begin(), lru, it->second);
+    return it->second->ch;
+}
+
+bool ChapterStore::Has(const std::string& t, int bookIdx, int ch) const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return index.count(Key(t, bookIdx, ch)) > 0;
+}
+
+void ChapterStore::Put(const std::string& t, ChapterRef ch) {
+    if (!ch) return;
+    std::string k = Key(t, ch->bookIndex, ch->chapter);
+    size_t bytes = ChapterBytes(*ch);
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = index.find(k);
+    if (it != index.end()) { used -= it->second->bytes; lru.erase(it->second); index.erase(it); }
+    lru.push_front({k, std::move(ch), bytes});
+    index[k] = lru.begin();
+    used += bytes;
+    Trim();
+}
+
+void ChapterStore::Erase(const std::string& t, int bookIdx, int ch) {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = index.find(Key(t, bookIdx, ch));
+    if (it == index.end()) return;
+    used -= it->second->bytes; lru.erase(it->second); index.erase(it);
+}
+
+void ChapterStore::Clear() {
+    std::lock_guard<std::mutex> lock(mtx);
+    lru.clear(); index.clear(); used = 0;
+}
+
+void ChapterStore::SetBudget(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mtx);
+    budget = bytes;
+    Trim();
+}
+
+void ChapterStore::Trim() {
+    // Evicted chapters stay alive for as long as a buffer or search still holds them
+    while (used > budget && !lru.empty()) {
+        used -= lru.back().bytes;
+        index.erase(lru.back().key);
+        lru.pop_back();
+    }
+}
+
+ChapterStoreStats ChapterStore::Stats() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return {hits, misses, (int)lru.size(), used, budget};
+}
+
 // --- StudyManager ---
 
-StudyManager::StudyManager() { file = "study_data.txt"; Load(); }
+static std::string StudyKey(const std::string& t, const std::string& b, int ch, int v) { return t + ":" + b + ":" + std::to_string(ch) + ":" + std::to_string(v); }
+
+// translation|book|chapter|verse|color|bookmarked|addedAt|text|note, with the note's newlines escaped;
+// the snapshot holds one per annotation and a journal "P" record carries one after the tag
+static std::string StudyLine(const VerseData& d) {
+    return d.translation + "|" + d.book + "|" + std::to_string(d.chapter) + "|" + std::to_string(d.verse) + "|" + std::to_string(d.highlightColor) + "|" + (d.isBookmarked ? "1" : "0") + "|" + std::to_string((long long)d.addedAt) + "|" + d.text + "|" + ReplaceAll(d.note, "\n", "\\n");
+}
+
+static bool ParseStudyLine(const std::string& ln, VerseData& d) {
+    std::istringstream ls(ln); std::string temp;
+    std::getline(ls, d.translation, '|');
+    std::getline(ls, d.book, '|');
+    std::getline(ls, temp, '|'); try { d.chapter = std::stoi(temp); } catch(...) { d.chapter = 1; }
+    std::getline(ls, temp, '|'); try { d.verse = std::stoi(temp); } catch(...) { d.verse = 1; }
+    std::getline(ls, temp, '|'); try { d.highlightColor = std::stoi(temp); } catch(...) { d.highlightColor = 0; }
+    std::getline(ls, temp, '|'); try { d.isBookmarked = (temp == "1"); } catch(...) { d.isBookmarked = false; }
+    std::getline(ls, temp, '|'); try { d.addedAt = (time_t)std::stoll(temp); } catch(...) { d.addedAt = 0; }
+    std::getline(ls, d.text, '|');
+    std::getline(ls, d.note);
+    d.note = ReplaceAll(d.note, "\\n", "\n");
+    return !d.book.empty();
+}
+
+StudyManager::StudyManager() { file = "study_data.txt"; journal = "study_data.journal"; Load(); }
+
+StudyManager::~StudyManager() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        quit = true;
+    }
+    wake.notify_one();
+    if (writer.joinable()) writer.join(); // Writes what is still pending on the way out
+}
+
 void StudyManager::Load() {
-    std::string c = ReadFile(file);
-    if (c.empty()) return;
-    std::istringstream iss(c); std::string ln;
-    while (std::getline(iss, ln)) {
-        if (ln.empty()) continue;
-        std::istringstream ls(ln); VerseData d; std::string temp;
-        std::getline(ls, d.translation, '|');
-        std::getline(ls, d.book, '|');
-        std::getline(ls, temp, '|'); try { d.chapter = std::stoi(temp); } catch(...) { d.chapter = 1; }
-        std::getline(ls, temp, '|'); try { d.verse = std::stoi(temp); } catch(...) { d.verse = 1; }
-        std::getline(ls, temp, '|'); try { d.highlightColor = std::stoi(temp); } catch(...) { d.highlightColor = 0; }
-        std::getline(ls, temp, '|'); try { d.isBookmarked = (temp == "1"); } catch(...) { d.isBookmarked = false; }
-        std::getline(ls, temp, '|'); try { d.addedAt = (time_t)std::stoll(temp); } catch(...) { d.addedAt = 0; }
-        std::getline(ls, d.text, '|');
-        std::getline(ls, d.note);
-        d.note = ReplaceAll(d.note, "\\n", "\n");
-        if (!d.book.empty()) data.push_back(d);
+    std::lock_guard<std::mutex> lock(mtx);
+    std::istringstream iss(ReadFile(file)); std::string ln;
+    while (std::getline(iss, ln)) if (!ln.empty()) Apply("P|" + ln);
+    // A crash mid-append leaves a last line without its newline; that batch was never
+    // synced, so the edit is dropped rather than half applied, and cut off the file so
+    // the next append starts on a line of its own
+    std::string j = ReadFile(journal);
+    size_t whole = j.rfind('\n') == std::string::npos ? 0 : j.rfind('\n') + 1;
+    if (whole < j.size()) { j.resize(whole); WriteFileAtomic(journal, j, true); }
+    std::istringstream js(j);
+    while (std::getline(js, ln)) if (!ln.empty()) { Apply(ln); journaled++; }
+}
+
+// P|<line> puts an annotation, R|<key> removes one, C clears them all. Each leaves the
+// same state however often it is replayed, so a journal that outlived its compaction
+// replays safely over the snapshot that already holds it.
+void StudyManager::Apply(const std::string& line) {
+    std::string rest = line.size() > 2 ? line.substr(2) : std::string();
+    if (line[0] == 'P') {
+        VerseData d;
+        if (!ParseStudyLine(rest, d)) return;
+        std::string k = d.GetKey();
+        auto it = index.find(k);
+        if (it != index.end()) { *it->second = std::move(d); return; }
+        data.push_back(std::move(d));
+        index.emplace(k, std::prev(data.end()));
+    } else if (line[0] == 'R') {
+        auto it = index.find(rest);
+        if (it == index.end()) return;
+        data.erase(it->second); index.erase(it);
+    } else if (line[0] == 'C') {
+        data.clear(); index.clear();
     }
 }
-void StudyManager::Save() {
-    std::ostringstream o;
-    for (const auto& d : data) {
-        std::string escapedNote = ReplaceAll(d.note, "\n", "\\n");
-        o << d.translation << "|" << d.book << "|" << d.chapter << "|" << d.verse << "|" << d.highlightColor << "|" << (d.isBookmarked ? "1" : "0") << "|" << (long long)d.addedAt << "|" << d.text << "|" << escapedNote << "\n";
+
+VerseData& StudyManager::Entry(const std::string& b, int ch, int v, const std::string& t, const std::string& text) {
+    std::string k = StudyKey(t, b, ch, v);
+    auto it = index.find(k);
+    if (it == index.end()) {
+        VerseData d; d.book = b; d.chapter = ch; d.verse = v; d.translation = t; d.addedAt = time(nullptr);
+        data.push_back(d);
+        it = index.emplace(k, std::prev(data.end())).first;
     }
-    WriteFile(file, o.str());
+    if (!text.empty()) it->second->text = text;
+    return *it->second;
+}
+
+void StudyManager::Log(const std::string& line) {
+    pending += line; pending += '\n';
+    if (!writer.joinable()) writer = std::thread(&StudyManager::WriterLoop, this);
+    wake.notify_one();
+}
+
+// Waits flushMs after the first edit of a batch, so a burst ("Bookmark All") costs one fsync
+void StudyManager::WriterLoop() {
+    std::unique_lock<std::mutex> lock(mtx);
+    while (!quit) {
+        wake.wait(lock, [this] { return quit || !pending.empty(); });
+        wake.wait_for(lock, std::chrono::milliseconds(flushMs), [this] { return quit; });
+        lock.unlock();
+        Flush();
+        lock.lock();
+    }
+    lock.unlock();
+    Flush();
+}
+
+void StudyManager::Flush() {
+    std::lock_guard<std::mutex> io(ioMtx); // Batches reach the file in the order they were logged
+    std::string batch, snapshot;
+    bool compact = false;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (pending.empty()) return;
+        batch.swap(pending);
+        journaled += (int)std::count(batch.begin(), batch.end(), '\n');
+        // Rewriting the snapshot costs one line per annotation, so it waits until the journal
+        // is half that long: edits stay O(1) amortized however large the collection grows
+        compact = journaled >= std::max(compactMin, (int)data.size() / 2);
+        if (compact) for (const auto& d : data) { snapshot += StudyLine(d); snapshot += '\n'; }
+    }
+    if (!AppendFileSync(journal, batch)) {
+        // Disk full or no permission: the batch goes back ahead of later edits for the
+        // writer's next round, and the snapshot waits until the journal is whole again
+        std::lock_guard<std::mutex> lock(mtx);
+        journaled -= (int)std::count(batch.begin(), batch.end(), '\n');
+        pending.insert(0, batch);
+        return;
+    }
+    if (!compact || !WriteFileAtomic(file, snapshot, true)) return; // The journal keeps everything until a snapshot sticks
+    remove(journal.c_str()); // All of it is in the snapshot; later edits are still in pending
+    std::lock_guard<std::mutex> lock(mtx);
+    journaled = 0;
 }
 
 void StudyManager::SetNote(const std::string& b, int ch, int v, const std::string& t, const std::string& note, const std::string& text) {
     std::lock_guard<std::mutex> lock(mtx);
-    std::string k = t + ":" + b + ":" + std::to_string(ch) + ":" + std::to_string(v);
-    for (auto& d : data) {
-        if (d.GetKey() == k) { d.note = note; if (!text.empty()) d.text = text; Save(); return; }
-    }
-    VerseData d; d.book = b; d.chapter = ch; d.verse = v; d.translation = t; d.note = note; d.text = text; d.addedAt = time(nullptr);
-    data.push_back(d); Save();
+    VerseData& d = Entry(b, ch, v, t, text);
+    d.note = note;
+    Log("P|" + StudyLine(d));
 }
 
 void StudyManager::SetHighlight(const std::string& b, int ch, int v, const std::string& t, int color, const std::string& text) {
     std::lock_guard<std::mutex> lock(mtx);
-    std::string k = t + ":" + b + ":" + std::to_string(ch) + ":" + std::to_string(v);
-    for (auto& d : data) {
-        if (d.GetKey() == k) { d.highlightColor = color; if (!text.empty()) d.text = text; Save(); return; }
-    }
-    VerseData d; d.book = b; d.chapter = ch; d.verse = v; d.translation = t; d.highlightColor = color; d.text = text; d.addedAt = time(nullptr);
-    data.push_back(d); Save();
+    VerseData& d = Entry(b, ch, v, t, text);
+    d.highlightColor = color;
+    Log("P|" + StudyLine(d));
 }
 
 void StudyManager::SetBookmark(const std::string& b, int ch, int v, const std::string& t, bool bookmarked, const std::string& text) {
     std::lock_guard<std::mutex> lock(mtx);
-    std::string k = t + ":" + b + ":" + std::to_string(ch) + ":" + std::to_string(v);
-    for (auto& d : data) {
-        if (d.GetKey() == k) { d.isBookmarked = bookmarked; if (!text.empty()) d.text = text; Save(); return; }
-    }
-    VerseData d; d.book = b; d.chapter = ch; d.verse = v; d.translation = t; d.isBookmarked = bookmarked; d.text = text; d.addedAt = time(nullptr);
-    data.push_back(d); Save();
+    VerseData& d = Entry(b, ch, v, t, text);
+    d.isBookmarked = bookmarked;
+    Log("P|" + StudyLine(d));
 }
 
 VerseData* StudyManager::Get(const std::string& b, int ch, int v, const std::string& t) {
     std::lock_guard<std::mutex> lock(mtx);
-    std::string k = t + ":" + b + ":" + std::to_string(ch) + ":" + std::to_string(v);
-    for (auto& d : data) if (d.GetKey() == k) return &d;
-    return nullptr;
+    auto it = index.find(StudyKey(t, b, ch, v));
+    return it == index.end() ? nullptr : &*it->second;
 }
 
 bool StudyManager::HasAny(const std::string& b, int ch, int v, const std::string& t) const {
     std::lock_guard<std::mutex> lock(mtx);
-    std::string k = t + ":" + b + ":" + std::to_string(ch) + ":" + std::to_string(v);
-    for (const auto& d : data) if (d.GetKey() == k) return (d.highlightColor > 0 || d.isBookmarked || !d.note.empty());
-    return false;
+    auto it = index.find(StudyKey(t, b, ch, v));
+    if (it == index.end()) return false;
+    const VerseData& d = *it->second;
+    return d.highlightColor > 0 || d.isBookmarked || !d.note.empty();
 }
 
 void StudyManager::Remove(const std::string& b, int ch, int v, const std::string& t) {
     std::lock_guard<std::mutex> lock(mtx);
-    std::string k = t + ":" + b + ":" + std::to_string(ch) + ":" + std::to_string(v);
-    data.erase(std::remove_if(data.begin(), data.end(), [&k](const VerseData& d) { return d.GetKey() == k; }), data.end());
-    Save();
+    std::string k = StudyKey(t, b, ch, v);
+    auto it = index.find(k);
+    if (it == index.end()) return;
+    data.erase(it->second); index.erase(it);
+    Log("R|" + k);
 }
 
 void StudyManager::ClearAll() {
     std::lock_guard<std::mutex> lock(mtx);
-    data.clear();
-    Save();
+    data.clear(); index.clear();
+    Log("C");
 }
 
 std::vector<VerseData> StudyManager::All() const {
     std::lock_guard<std::mutex> lock(mtx);
-    return data;
+    return std::vector<VerseData>(data.begin(), data.end());
 }
 
 // --- HistoryManager ---
@@ -283,6 +726,18 @@ void SettingsManager::Load() {
         else if (k == "bookMode") bookMode = (v == "1");
         else if (k == "lastScrollY") lastScrollY = std::stof(v);
         else if (k == "lastPageIdx") lastPageIdx = std::stoi(v);
+        else if (k == "chapterCacheMB") chapterCacheMB = std::stoi(v);
+        else if (k == "compressCache") compressCache = (v == "1");
+        else if (k == "apiBase") apiBase = v;
+        else if (k == "downloadConcurrency") downloadConcurrency = std::stoi(v);
+        else if (k == "downloadRate") downloadRate = std::stof(v);
+        else if (k == "cacheQuotaMB") cacheQuotaMB = std::stoi(v);
+        else if (k == "transport") transport = v;
+        else if (k == "fixtureDir") fixtureDir = v;
+        else if (k == "stubLatencyMs") stubLatencyMs = std::stoi(v);
+        else if (k == "stubErrorRate") stubErrorRate = std::stof(v);
+        else if (k == "prefetchMB") prefetchMB = std::stoi(v);
+        else if (k == "prefetchPerMinute") prefetchPerMinute = std::stoi(v);
         else if (k == "winW") winW = std::stoi(v);
         else if (k == "winH") winH = std::stoi(v);
         else if (k == "winX") winX = std::stoi(v);
@@ -291,6 +746,6 @@ void SettingsManager::Load() {
 }
 void SettingsManager::Save() {
     std::ostringstream o;
-    o << "theme " << theme << "\nfontSize " << fontSize << "\nlineSpacing " << lineSpacing << "\nlastBookIdx " << lastBookIdx << "\nlastChNum " << lastChNum << "\nlastTransIdx " << lastTransIdx << "\nparallelMode " << (parallelMode ? "1" : "0") << "\ntransIdx2 " << transIdx2 << "\nbookMode " << (bookMode ? "1" : "0") << "\nlastScrollY " << lastScrollY << "\nlastPageIdx " << lastPageIdx << "\nwinW " << winW << "\nwinH " << winH << "\nwinX " << winX << "\nwinY " << winY << "\n";
+    o << "theme " << theme << "\nfontSize " << fontSize << "\nlineSpacing " << lineSpacing << "\nlastBookIdx " << lastBookIdx << "\nlastChNum " << lastChNum << "\nlastTransIdx " << lastTransIdx << "\nparallelMode " << (parallelMode ? "1" : "0") << "\ntransIdx2 " << transIdx2 << "\nbookMode " << (bookMode ? "1" : "0") << "\nlastScrollY " << lastScrollY << "\nlastPageIdx " << lastPageIdx << "\nchapterCacheMB " << chapterCacheMB << "\ncompressCache " << (compressCache ? "1" : "0") << "\napiBase " << apiBase << "\ndownloadConcurrency " << downloadConcurrency << "\ndownloadRate " << downloadRate << "\ncacheQuotaMB " << cacheQuotaMB << "\ntransport " << transport << "\nfixtureDir " << fixtureDir << "\nstubLatencyMs " << stubLatencyMs << "\nstubErrorRate " << stubErrorRate << "\nprefetchMB " << prefetchMB << "\nprefetchPerMinute " << prefetchPerMinute << "\nwinW " << winW << "\nwinH " << winH << "\nwinX " << winX << "\nwinY " << winY << "\n";
     WriteFile(file, o.str());
 }
\ No newline at end of file
@@ -3,33 +3,139 @@
 #define MANAGERS_H
 
 #include "raybible.h"
+#include "cache_archive.h"
 #include <string>
 #include <vector>
+#include <map>
+#include <list>
+#include <unordered_map>
+#include <memory>
 #include <mutex>
+#include <shared_mutex>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+#include <deque>
 
 class CacheManager {
+    struct Store {
+        ChapterArchive archive;
+        CacheManifest manifest;
+        uint64_t serial; // Tells a reopened store apart from the one a compaction started on
+        std::mutex touchMtx; // Access times are the only thing readers write
+        Store(const std::string& path, uint64_t n) : archive(path), serial(n) {}
+    };
     std::string base;
+    // Legacy one-file-per-chapter layout, only read when migrating into an archive
     std::string Path(const std::string& t, const std::string& b, int c) const;
     std::string TDir(const std::string& t) const;
     std::string BDir(const std::string& t, const std::string& b) const;
-    mutable std::mutex mtx;
+    std::string ArchivePath(const std::string& t) const;
+    std::string ManifestPath(const std::string& t) const;
+    std::string DictPath() const;
+    mutable std::map<std::string, std::unique_ptr<Store>> stores;
+    mutable uint64_t nextSerial = 0;
+    // Shared compression dictionary, trained once from the first chapters written
+    mutable SharedDictionary dict;
+    mutable std::vector<std::string> dictSamples;
+    mutable size_t sampleBytes = 0;
+    mutable bool training = false; // A Save is training on the samples it took
+    mutable uint64_t dictEpoch = 0; // Bumped by a clear, so a training round that spans one is dropped
+    bool compress = false;
+    std::string Pack(const std::string& rec) const; // Caller holds mtx
+    void TrainWhenReady(std::unique_lock<std::shared_mutex>& lock) const; // lock is mtx, held exclusively
+    Store* Find(const std::string& t, bool create) const; // Caller holds mtx exclusively
+    Store* Lookup(const std::string& t) const; // Caller holds mtx, shared is enough; never opens
+    void OpenStore(const std::string& t) const; // First use of a translation takes mtx exclusively once
+    void MigrateLegacy(const std::string& t, ChapterArchive& a) const;
+    void Reconcile(const std::string& t, Store& st) const;
+    void FlushManifest(const std::string& t, Store& st, int threshold) const;
+    // Loads, Has and Stats share mtx; anything that changes an archive, a manifest or the
+    // store map holds it exclusively. Acquisitions that had to wait are counted.
+    mutable std::shared_mutex mtx;
+    mutable std::mutex gate;
+    mutable std::atomic<long> lockCount{0}, readWaits{0}, writeWaits{0};
+    std::shared_lock<std::shared_mutex> ReadLock() const;
+    std::unique_lock<std::shared_mutex> WriteLock() const;
+
+    // Background janitor: keeps the archives under the disk quota by evicting the least
+    // recently read chapters, compacts the space that frees, and runs user evictions, so
+    // Load/Save only ever wait for a short batch of table updates.
+    struct Eviction { std::string t; int bookIdx; }; // Empty t = everything, bookIdx -1 = whole translation
+    std::thread janitor;
+    mutable std::condition_variable_any jcv;
+    std::deque<Eviction> evictions;
+    mutable bool jwake = false;
+    bool jquit = false, jbusy = false;
+    uint64_t quota = 0; // 0 = unlimited
+    long evicted = 0;
+    void StartJanitor(); // Caller holds mtx
+    void JanitorLoop();
+    std::string RunEviction(const Eviction& ev); // Caller holds mtx; returns the translation to compact
+    bool EnforceQuota();
+    void Compact(const std::string& t, bool force);
+    uint64_t DiskBytes() const; // Caller holds mtx
 public:
     CacheManager();
+    ~CacheManager();
     bool Has(const std::string& t, const std::string& b, int c) const;
     Chapter Load(const std::string& t, const std::string& b, int cn) const;
     bool Save(const Chapter& ch) const;
-    void ClearCache();
+    bool Remove(const std::string& t, const std::string& b, int c);
+    void Evict(const std::string& t, int bookIdx = -1); // Queued for the janitor; -1 = whole translation
+    void ClearCache(); // Queued like Evict
+    void SetQuota(uint64_t bytes); // 0 = unlimited
     CacheStats Stats() const;
+    void SetCompression(bool on);
 };
 
+// Process-wide LRU of parsed chapters, bounded by an approximate byte budget
+class ChapterStore {
+    struct Node { std::string key; ChapterRef ch; size_t bytes; };
+    std::list<Node> lru; // Most recently used at the front
+    std::unordered_map<std::string, std::list<Node>::iterator> index;
+    size_t budget = 64u << 20;
+    size_t used = 0;
+    long hits = 0, misses = 0;
+    mutable std::mutex mtx;
+    static std::string Key(const std::string& t, int bookIdx, int ch);
+    void Trim(); // Caller holds mtx
+public:
+    ChapterRef Get(const std::string& t, int bookIdx, int ch);
+    bool Has(const std::string& t, int bookIdx, int ch) const; // Neither counts nor refreshes
+    void Put(const std::string& t, ChapterRef ch);
+    void Erase(const std::string& t, int bookIdx, int ch);
+    void Clear();
+    void SetBudget(size_t bytes);
+    ChapterStoreStats Stats() const;
+};
+
+// Notes, highlights and bookmarks, held in memory and indexed by verse key. An edit only
+// appends a line to an in-memory log; a writer thread appends the log to the journal
+// with one fsync per batch and, once the journal outgrows half the annotation count,
+// folds everything into the snapshot and starts the journal afresh. Load replays the
+// journal over the snapshot, skipping a last line torn by a crash.
 class StudyManager {
-    std::vector<VerseData> data;
-    std::string file;
+    std::list<VerseData> data; // In the order they were added
+    std::unordered_map<std::string, std::list<VerseData>::iterator> index;
+    std::string file, journal;
+    std::string pending;    // Journal lines not yet written
+    int journaled = 0;      // Records in the journal since the last compaction
+    int flushMs = 250;      // Longest an edit waits before it is on disk
+    int compactMin = 256;
     mutable std::mutex mtx;
+    std::mutex ioMtx;       // Orders journal and snapshot writes; taken before mtx
+    std::condition_variable wake;
+    std::thread writer;     // Started by the first edit
+    bool quit = false;
     void Load();
-    void Save();
+    void Apply(const std::string& line); // One journal line; caller holds mtx
+    VerseData& Entry(const std::string& b, int ch, int v, const std::string& t, const std::string& text); // Found or added; caller holds mtx
+    void Log(const std::string& line);   // Caller holds mtx
+    void WriterLoop();
 public:
     StudyManager();
+    ~StudyManager();
     // CRUD
     void SetNote(const std::string& b, int ch, int v, const std::string& t, const std::string& note, const std::string& text = "");
     void SetHighlight(const std::string& b, int ch, int v, const std::string& t, int color, const std::string& text = "");
@@ -39,6 +145,7 @@ public:
     bool HasAny(const std::string& b, int ch, int v, const std::string& t) const;
     void Remove(const std::string& b, int ch, int v, const std::string& t);
     void ClearAll();
+    void Flush(); // Returns once every edit so far is in the journal on disk
     
     std::vector<VerseData> All() const;
 };
@@ -70,6 +177,18 @@ public:
     bool bookMode = false;
     float lastScrollY = 0.0f;
     int lastPageIdx = 0;
+    int chapterCacheMB = 64;
+    bool compressCache = false; // Off until expanding a record costs Load no more than reading a plain one
+    std::string apiBase = "https://bolls.life"; // Point at a local stub server for offline testing
+    int downloadConcurrency = 4;
+    float downloadRate = 8.0f; // Requests per second during bulk downloads
+    int cacheQuotaMB = 512; // Disk cache limit; 0 = unlimited
+    std::string transport = "http"; // http, replay, record or stub (see SelectTransport)
+    std::string fixtureDir = "fixtures";
+    int stubLatencyMs = 0;
+    float stubErrorRate = 0.0f;
+    int prefetchMB = 8;          // Memory held by chapters warmed ahead of the reader
+    int prefetchPerMinute = 30;  // Network fetches for them; 0 warms from the disk cache only
     
     // Window state
     int winW = 1140;
@@ -81,7 +200,10 @@ public:
     void Save();
 };
 
+size_t ChapterBytes(const Chapter& ch); // Approximate heap footprint
+
 extern CacheManager g_cache;
+extern ChapterStore g_chapters;
 extern StudyManager g_study;
 extern HistoryManager g_hist;
 extern SettingsManager g_settings;
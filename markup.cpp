@@ -0,0 +1,74 @@
+#include "markup.h"
+#include "simd_scan.h"
+#include <algorithm>
+
+// The one clean-up pass behind both StripTags and CleanVerseText. Appends to `out`;
+// Strong's numbers go to `tags` (positions relative to where this text starts) when it
+// is given. Returns the appended length.
+template <class Out>
+static size_t CleanMarkup(std::string_view raw, Out& out, std::vector<StrongsTag>* tags) {
+    static const std::pair<std::string_view, char> ENTITIES[] = {{"&lt;", '<'}, {"&gt;", '>'}, {"&amp;", '&'}, {"&quot;", '"'}};
+    const size_t base = out.size(), tagBase = tags ? tags->size() : 0;
+    auto put = [&](char c) {
+        if (c == '\n') c = ' ';
+        if (c == ' ' && (out.size() == base || out.back() == ' ')) return; // Collapse runs, no leading space
+        out.push_back(c);
+    };
+    // Every byte that needs a decision, found in one vectorized pass; runs in between are copied whole
+    thread_local std::vector<uint32_t> marks;
+    MarkupIndex(raw, marks);
+    size_t k = 0;
+    auto nextMark = [&](size_t from, char want) {
+        while (k < marks.size() && (marks[k] < from || (want && raw[marks[k]] != want))) k++;
+        return k < marks.size() ? (size_t)marks[k] : std::string_view::npos;
+    };
+    for (size_t i = 0; i < raw.size(); i++) {
+        size_t m = nextMark(i, 0);
+        if (m == std::string_view::npos) m = raw.size();
+        if (m > i) {
+            if (raw[i] == ' ' && (out.size() == base || out.back() == ' ')) i++; // Runs hold no double spaces, only a join
+            out.insert(out.end(), raw.data() + i, raw.data() + m);
+            i = m;
+            if (i >= raw.size()) break;
+        }
+        char c = raw[i];
+        if (c == '&') {
+            bool hit = false;
+            for (const auto& e : ENTITIES) { if (raw.compare(i, e.first.size(), e.first) == 0) { put(e.second); i += e.first.size() - 1; hit = true; break; } }
+            if (!hit) put(c);
+            continue;
+        }
+        if (c != '<') { put(c); continue; }
+        size_t close = nextMark(i + 1, '>');
+        if (close == std::string_view::npos) break;
+        std::string_view tag = raw.substr(i + 1, close - i - 1);
+        i = close;
+        if (tag.empty() || (tag[0] != 'S' && tag[0] != 's')) continue; // Other markup and closing tags vanish
+        // <S>1234</S> carries the number as content, <S 1234> inside the tag
+        std::string_view num = tag.substr(1);
+        if (num.empty()) { size_t end = nextMark(i + 1, '<'); if (end == std::string_view::npos) end = raw.size(); num = raw.substr(i + 1, end - i - 1); i = end - 1; }
+        uint32_t n = 0; bool digits = false;
+        for (char d : num) if (d >= '0' && d <= '9') { n = n * 10 + (uint32_t)(d - '0'); digits = true; }
+        if (digits && tags) tags->push_back({(uint32_t)(out.size() - base), n});
+    }
+    auto blank = [](char c) { return c == ' ' || c == '\t' || c == '\r'; };
+    while (out.size() > base && blank(out.back())) out.pop_back();
+    // Leading spaces never get in, but a tab or carriage return can; rare enough to shift afterwards
+    size_t lead = 0;
+    while (base + lead < out.size() && blank(out[base + lead])) lead++;
+    if (lead) out.erase(out.begin() + base, out.begin() + base + lead);
+    size_t len = out.size() - base;
+    if (tags) for (size_t k = tagBase; k < tags->size(); k++) { uint32_t& p = (*tags)[k].pos; p = std::min<uint32_t>(p > lead ? p - (uint32_t)lead : 0, (uint32_t)len); }
+    return len;
+}
+
+std::string StripTags(std::string_view s) {
+    std::string r;
+    r.reserve(s.size()); // Clean text never outgrows its source
+    CleanMarkup(s, r, nullptr);
+    return r;
+}
+
+size_t CleanVerseText(std::string_view raw, std::vector<char>& out, std::vector<StrongsTag>& tags) {
+    return CleanMarkup(raw, out, &tags);
+}
@@ -0,0 +1,25 @@
+#pragma once
+#ifndef RAYBIBLE_MARKUP_H
+#define RAYBIBLE_MARKUP_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+// Strong's number that was tagged in the source text, anchored at the byte offset in
+// the clean text where the tag stood (just after the word it annotates)
+struct StrongsTag {
+    uint32_t pos;
+    uint32_t number;
+};
+
+// Clean-up of the marked-up text the API serves (verses, lexicon definitions): the four
+// entities &lt; &gt; &amp; &quot; are decoded, markup and the numbers inside Strong's
+// tags are dropped, newlines become spaces, space runs collapse and both ends are
+// trimmed of spaces, tabs and carriage returns. Entities are decoded after tags are
+// recognized, so escaped markup (&lt;S&gt;) stays in the text as written.
+std::string StripTags(std::string_view s);
+size_t CleanVerseText(std::string_view raw, std::vector<char>& out, std::vector<StrongsTag>& tags); // Appends clean text and the Strong's tags lifted out of it
+
+#endif // RAYBIBLE_MARKUP_H
@@ -0,0 +1,94 @@
+#include "prefetcher.h"
+#include "managers.h"
+#include "transport.h"
+#include <algorithm>
+
+Prefetcher g_prefetch;
+
+std::string Prefetcher::Key(const std::string& t, int bookIdx, int ch) { return t + ":" + std::to_string(bookIdx) + ":" + std::to_string(ch); }
+
+void Prefetcher::SetBudgets(size_t bytes, int perMinute) {
+    std::lock_guard<std::mutex> lock(mtx);
+    memBudget = bytes; fetchesPerMin = std::max(perMinute, 0);
+}
+
+bool Prefetcher::Holds(const std::string& key) const {
+    return std::any_of(held.begin(), held.end(), [&](const Held& h) { return h.key == key; });
+}
+
+// Room for a fetch this minute, after forgetting fetches older than that
+int Prefetcher::FetchAllowance() {
+    auto now = std::chrono::steady_clock::now();
+    while (!recentFetches.empty() && now - recentFetches.front() > std::chrono::minutes(1)) recentFetches.pop_front();
+    return std::max(fetchesPerMin - (int)recentFetches.size(), 0);
+}
+
+void Prefetcher::Keep(const std::string& t, ChapterRef ch) {
+    std::lock_guard<std::mutex> lock(mtx);
+    std::string key = Key(t, ch->bookIndex, ch->chapter);
+    if (Holds(key)) return;
+    size_t bytes = ChapterBytes(*ch);
+    held.push_back({key, ch, bytes});
+    stats.heldBytes += bytes; stats.warmed++;
+}
+
+void Prefetcher::Run(const std::vector<ChapterRequest>& wanted, const CancelToken& tok) {
+    {
+        // Guesses the reader has moved away from, or that memory pressure already evicted,
+        // will not turn into hits; dropping them makes room for the new ones
+        std::lock_guard<std::mutex> lock(mtx);
+        for (auto it = held.begin(); it != held.end();) {
+            ChapterRef ch = it->ch.lock();
+            bool stillWanted = ch && std::any_of(wanted.begin(), wanted.end(), [&](const ChapterRequest& r) { return Key(r.trans, r.bookIdx, r.chNum) == it->key; });
+            if (stillWanted) { ++it; continue; }
+            if (ch) g_chapters.Erase(ch->translation, ch->bookIndex, ch->chapter);
+            stats.heldBytes -= it->bytes; stats.wasted++;
+            it = held.erase(it);
+        }
+    }
+    // Fetches go out a few at a time, so the memory budget is overshot by one batch at most
+    std::vector<ChapterRequest> remote;
+    auto fetch = [&] {
+        LoadOrFetchMany(remote, [&](size_t i, ChapterRef ch) {
+            // Only real content reaches the memory store; an error placeholder is not worth holding
+            if (!g_chapters.Has(remote[i].trans, remote[i].bookIdx, remote[i].chNum)) return;
+            Keep(remote[i].trans, ch);
+            std::lock_guard<std::mutex> lock(mtx);
+            stats.fetched++;
+        });
+        remote.clear();
+    };
+    for (const auto& r : wanted) {
+        if (tok.Cancelled()) return;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (stats.heldBytes >= memBudget) break;
+            if (Holds(Key(r.trans, r.bookIdx, r.chNum))) continue;
+        }
+        if (g_chapters.Has(r.trans, r.bookIdx, r.chNum)) continue; // Already warm, and not on our account
+        if (g_cache.Has(r.trans, BIBLE_BOOKS[r.bookIdx].abbrev, r.chNum)) { if (ChapterRef ch = LoadCached(r.bookIdx, r.chNum, r.trans)) Keep(r.trans, ch); continue; }
+        if (g_transport->Offline()) continue;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            if (FetchAllowance() == 0) continue; // Disk-cached guesses further down may still be warmed
+            recentFetches.push_back(std::chrono::steady_clock::now());
+        }
+        remote.push_back(r);
+        if (remote.size() == fetchBatch) fetch();
+    }
+    if (!remote.empty() && !tok.Cancelled()) fetch();
+}
+
+void Prefetcher::Claim(const std::string& t, int bookIdx, int ch) {
+    std::lock_guard<std::mutex> lock(mtx);
+    std::string key = Key(t, bookIdx, ch);
+    auto it = std::find_if(held.begin(), held.end(), [&](const Held& h) { return h.key == key; });
+    if (it == held.end()) return;
+    stats.heldBytes -= it->bytes; stats.hits++;
+    held.erase(it);
+}
+
+PrefetchStats Prefetcher::Stats() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return stats;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#ifndef RAYBIBLE_PREFETCHER_H
+#define RAYBIBLE_PREFETCHER_H
+
+#include "raybible.h"
+#include "bible_logic.h"
+#include "task_scheduler.h"
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <mutex>
+#include <chrono>
+
+struct PrefetchStats {
+    long warmed = 0;  // Chapters brought into memory ahead of time
+    long fetched = 0; // Of those, the ones that needed the network
+    long hits = 0;    // Shown while still held
+    long wasted = 0;  // Dropped unseen: pushed out by newer guesses or evicted from memory
+    size_t heldBytes = 0;
+};
+
+// Warms the chapters the reader is likely to open next into the memory store, so a page
+// turn or jump finds them parsed and ready. Guesses come from AppState in order of
+// likelihood; those on disk are just loaded, the rest are fetched while the network
+// budget (fetches per minute) allows. A prefetched chapter is held until it is shown (a
+// hit) or drops out of the guesses (wasted); the memory budget caps what is held at once.
+class Prefetcher {
+    struct Held { std::string key; std::weak_ptr<const Chapter> ch; size_t bytes; };
+    std::deque<Held> held; // Oldest first
+    std::deque<std::chrono::steady_clock::time_point> recentFetches; // Inside the last minute
+    size_t memBudget = 8u << 20;
+    int fetchesPerMin = 30;
+    size_t fetchBatch = 2; // Both columns of a chapter in parallel mode
+    PrefetchStats stats;
+    mutable std::mutex mtx;
+
+    static std::string Key(const std::string& t, int bookIdx, int ch);
+    bool Holds(const std::string& key) const; // Caller holds mtx
+    void Keep(const std::string& t, ChapterRef ch);
+    int FetchAllowance(); // Caller holds mtx
+public:
+    void SetBudgets(size_t bytes, int perMinute); // 0 fetches a minute keeps prefetch to the disk cache
+    // Warms `wanted` in order; runs on a Prefetch task and stops early once cancelled
+    void Run(const std::vector<ChapterRequest>& wanted, const CancelToken& tok);
+    void Claim(const std::string& t, int bookIdx, int ch); // A chapter is being shown: a hit if it was prefetched
+    PrefetchStats Stats() const;
+};
+
+extern Prefetcher g_prefetch;
+
+#endif // RAYBIBLE_PREFETCHER_H
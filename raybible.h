@@ -3,7 +3,9 @@
 #define RAYBIBLE_H
 
 #include "raylib.h"
+#include "markup.h"
 #include <string>
+#include <string_view>
 #include <vector>
 #include <deque>
 #include <map>
@@ -11,27 +13,66 @@
 #include <thread>
 #include <mutex>
 #include <atomic>
+#include <memory>
+#include <cstdint>
 
 // --- Data Structures ---
 
+// Read-only slice of a chapter's tag arena
+struct TagSpan {
+    const StrongsTag* ptr = nullptr;
+    size_t count = 0;
+    const StrongsTag* begin() const { return ptr; }
+    const StrongsTag* end() const { return ptr + count; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const StrongsTag& operator[](size_t i) const { return ptr[i]; }
+};
+
+// Views into the owning chapter's arenas; text is NUL-terminated, so text.data() can be drawn directly
 struct Verse {
     int number;
-    std::string text;
-    std::string rawText; // Original with Strong's tags
+    std::string_view text; // Clean reading text
+    TagSpan tags;          // Sorted by pos; empty for untagged translations
 };
 
+// Owns one contiguous text arena and one tag arena for all of its verses. Moving keeps the
+// arenas (and so every Verse view) in place; copying would not, so chapters are move-only.
 struct Chapter {
     std::string book;
     std::string bookAbbrev;
-    int bookIndex;
-    int chapter;
+    int bookIndex = 0;
+    int chapter = 0;
     std::string translation;
     std::vector<Verse> verses;
-    time_t fetchedAt;
-    bool fromCache;
-    bool isLoaded;
+    time_t fetchedAt = 0;
+    std::string etag; // Server's validator for revalidating the cached copy; empty if it sent none
+    bool fromCache = false;
+    bool isLoaded = false;
+
+    Chapter() = default;
+    Chapter(Chapter&&) = default;
+    Chapter& operator=(Chapter&&) = default;
+    Chapter(const Chapter&) = delete;
+    Chapter& operator=(const Chapter&) = delete;
+
+    void Reserve(size_t verseCount, size_t textBytes, size_t tagCount); // Exact sizes avoid any regrowth
+    void AddVerse(int number, std::string_view text, const StrongsTag* tags = nullptr, size_t tagCount = 0);
+    bool AddTaggedVerse(int number, std::string_view raw); // Cleans straight into the arena; drops empty verses
+    void Fit(); // Trims the arenas to their contents once the chapter is complete
+    size_t ArenaBytes() const { return textArena.capacity() + tagArena.capacity() * sizeof(StrongsTag); }
+
+private:
+    std::vector<char> textArena;
+    std::vector<StrongsTag> tagArena;
+    void Grow(size_t textBytes, size_t tagCount); // Reallocates and re-points existing verses
+    void MoveText(size_t capacity);
+    void MoveTags(size_t capacity);
 };
 
+// Chapters are immutable once loaded and shared between the chapter store, buffers and search
+using ChapterRef = std::shared_ptr<const Chapter>;
+
 struct BookInfo {
     std::string name;
     std::string abbrev;
@@ -115,10 +156,25 @@ struct GlobalSearchMatch {
 struct CacheStats {
     int totalChapters;
     int totalVerses;
-    long totalSize;
+    long totalSize;   // On disk
+    long logicalSize; // Records before compression
+    long quota;       // 0 = unlimited
+    long evicted;     // Chapters dropped to stay under the quota
+    bool evicting;    // Janitor has work queued or running
+    long lockCount;   // Cache lock acquisitions, and how many had to wait for a writer / for anyone
+    long readWaits;
+    long writeWaits;
     std::map<std::string, int> byTranslation;
 };
 
+struct ChapterStoreStats {
+    long hits;
+    long misses;
+    int chapters;
+    size_t bytes;
+    size_t budget;
+};
+
 // --- Constants ---
 
 extern const std::vector<BookInfo> BIBLE_BOOKS;
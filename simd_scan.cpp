@@ -0,0 +1,158 @@
+#include "simd_scan.h"
+#include <cstring>
+
+#if defined(SCAN_FORCE_SCALAR)
+    // The plain loops on any CPU, so tests can check them against the vector paths
+#elif defined(__AVX2__)
+    #include <immintrin.h>
+    #define SCAN_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define SCAN_SSE2 1
+#endif
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+namespace {
+
+inline int Ctz(uint64_t x) {
+#if defined(_MSC_VER)
+    unsigned long i; _BitScanForward64(&i, x); return (int)i;
+#else
+    return __builtin_ctzll(x);
+#endif
+}
+
+// Running XOR of all lower bits: bit i ends up set when an odd number of bits at or
+// below i were set. Applied to quote positions this marks the inside of strings.
+inline uint64_t PrefixXor(uint64_t x) {
+    x ^= x << 1; x ^= x << 2; x ^= x << 4; x ^= x << 8; x ^= x << 16; x ^= x << 32;
+    return x;
+}
+
+// Bytes preceded by an odd run of backslashes. Runs are split into those starting on
+// even and odd bits; subtracting the run starts carries through each run and lands on
+// the byte after it, whose parity then says whether the run was odd. `carry` is 1 when
+// the previous block ended in an odd run, which escapes bit 0 of this one.
+inline uint64_t Escaped(uint64_t backslash, uint64_t& carry) {
+    const uint64_t ODD_BITS = 0xAAAAAAAAAAAAAAAAull;
+    uint64_t starts = backslash & ~carry; // An escaped backslash starts nothing
+    uint64_t series = ((starts << 1) | ODD_BITS) - starts;
+    uint64_t code = series ^ ODD_BITS;
+    uint64_t escaped = code ^ (backslash | carry);
+    carry = (code & backslash) >> 63;
+    return escaped;
+}
+
+// One 64-byte block, loaded once; AnyOf gives a bit per byte matching any of `set`
+struct Block {
+#if SCAN_AVX2
+    __m256i v[2];
+    explicit Block(const char* p) { v[0] = _mm256_loadu_si256((const __m256i*)p); v[1] = _mm256_loadu_si256((const __m256i*)(p + 32)); }
+    uint64_t AnyOf(const char* set, size_t n) const {
+        __m256i m0 = _mm256_setzero_si256(), m1 = m0;
+        for (size_t k = 0; k < n; k++) {
+            __m256i c = _mm256_set1_epi8(set[k]);
+            m0 = _mm256_or_si256(m0, _mm256_cmpeq_epi8(v[0], c)); m1 = _mm256_or_si256(m1, _mm256_cmpeq_epi8(v[1], c));
+        }
+        return (uint64_t)(uint32_t)_mm256_movemask_epi8(m0) | ((uint64_t)(uint32_t)_mm256_movemask_epi8(m1) << 32);
+    }
+    uint64_t AtMost(unsigned char c) const { // Unsigned byte <= c
+        __m256i l = _mm256_set1_epi8((char)c);
+        return (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_max_epu8(v[0], l), l)) | ((uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_max_epu8(v[1], l), l)) << 32);
+    }
+#elif SCAN_SSE2
+    __m128i v[4];
+    explicit Block(const char* p) { for (int i = 0; i < 4; i++) v[i] = _mm_loadu_si128((const __m128i*)(p + 16 * i)); }
+    uint64_t AnyOf(const char* set, size_t n) const {
+        __m128i m[4] = {_mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128()};
+        for (size_t k = 0; k < n; k++) {
+            __m128i c = _mm_set1_epi8(set[k]);
+            for (int i = 0; i < 4; i++) m[i] = _mm_or_si128(m[i], _mm_cmpeq_epi8(v[i], c));
+        }
+        uint64_t r = 0;
+        for (int i = 0; i < 4; i++) r |= (uint64_t)(uint32_t)_mm_movemask_epi8(m[i]) << (16 * i);
+        return r;
+    }
+    uint64_t AtMost(unsigned char c) const {
+        __m128i l = _mm_set1_epi8((char)c);
+        uint64_t r = 0;
+        for (int i = 0; i < 4; i++) r |= (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(v[i], l), l)) << (16 * i);
+        return r;
+    }
+#else
+    const char* p;
+    explicit Block(const char* b) : p(b) {}
+    uint64_t AnyOf(const char* set, size_t n) const {
+        uint64_t r = 0;
+        for (int i = 0; i < 64; i++) for (size_t k = 0; k < n; k++) if (p[i] == set[k]) { r |= 1ull << i; break; }
+        return r;
+    }
+    uint64_t AtMost(unsigned char c) const {
+        uint64_t r = 0;
+        for (int i = 0; i < 64; i++) if ((unsigned char)p[i] <= c) r |= 1ull << i;
+        return r;
+    }
+#endif
+    uint64_t AnyOf(std::string_view set) const { return AnyOf(set.data(), set.size()); }
+};
+
+// Calls f(block, base) for every 64-byte block; the tail is padded with `pad`, which
+// callers pick (or mask off) so that it never produces a position
+template <class F> void ForEachBlock(std::string_view s, char pad, F f) {
+    size_t i = 0;
+    for (; i + 64 <= s.size(); i += 64) f(Block(s.data() + i), i);
+    if (i < s.size()) {
+        char tail[64];
+        memset(tail, pad, sizeof(tail));
+        memcpy(tail, s.data() + i, s.size() - i);
+        f(Block(tail), i);
+    }
+}
+
+inline void Emit(uint64_t bits, size_t base, std::vector<uint32_t>& out) {
+    while (bits) { out.push_back((uint32_t)(base + Ctz(bits))); bits &= bits - 1; }
+}
+
+} // namespace
+
+const char* ScanPath() {
+#if SCAN_AVX2
+    return "AVX2";
+#elif SCAN_SSE2
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+void MarkupIndex(std::string_view s, std::vector<uint32_t>& out) {
+    out.clear();
+    uint64_t spaceCarry = 0;
+    size_t tailLen = s.size() % 64;
+    ForEachBlock(s, '\0', [&](const Block& b, size_t base) {
+        uint64_t space = b.AnyOf(" ", 1);
+        uint64_t bits = b.AnyOf("<>&\n", 4) | (space & ((space << 1) | spaceCarry));
+        spaceCarry = space >> 63;
+        if (base + 64 > s.size() && tailLen) bits &= (1ull << tailLen) - 1;
+        Emit(bits, base, out);
+    });
+}
+
+void JsonStructuralIndex(std::string_view doc, std::vector<uint32_t>& out) {
+    out.clear();
+    out.reserve(doc.size() / 5); // Chapter responses come to about one entry per 6 bytes
+    uint64_t inStringCarry = 0, scalarCarry = 0, escapeCarry = 0;
+    ForEachBlock(doc, ' ', [&](const Block& b, size_t base) {
+        uint64_t escaped = Escaped(b.AnyOf("\\", 1), escapeCarry);
+        uint64_t quotes = b.AnyOf("\"", 1) & ~escaped;
+        uint64_t inString = PrefixXor(quotes) ^ inStringCarry; // Opening quote and contents, not the closing quote
+        inStringCarry = (uint64_t)((int64_t)inString >> 63);
+        uint64_t ops = b.AnyOf("{}[],:", 6), space = b.AtMost(' '); // Control bytes count as whitespace
+        uint64_t scalar = ~(ops | quotes | space | inString);
+        uint64_t scalarStart = scalar & ~((scalar << 1) | scalarCarry);
+        scalarCarry = scalar >> 63;
+        Emit((ops & ~inString) | quotes | scalarStart, base, out);
+    });
+}
@@ -0,0 +1,25 @@
+#pragma once
+#ifndef RAYBIBLE_SIMD_SCAN_H
+#define RAYBIBLE_SIMD_SCAN_H
+
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+// Bulk byte classification, 64 input bytes per step: AVX2 when the build enables it,
+// SSE2 on any x86-64, plain loops elsewhere. Results are positions, so callers hop
+// from one interesting byte to the next instead of branching on every byte. Defining
+// SCAN_FORCE_SCALAR builds the plain loops everywhere.
+const char* ScanPath(); // "AVX2", "SSE2" or "scalar": the one this build uses
+
+// Markup index of verse text: every '<', '>', '&' and '\n', plus each space that follows
+// another space. Runs between two positions can be copied as they are, except that a
+// run may start with a space that joins one already written.
+void MarkupIndex(std::string_view s, std::vector<uint32_t>& out);
+
+// JSON structural index: unescaped quotes, { } [ ] , : outside strings, and the first
+// byte of every number or literal. The bytes between two positions are whitespace or
+// the rest of a scalar; a string runs from one quote position to the next.
+void JsonStructuralIndex(std::string_view doc, std::vector<uint32_t>& out);
+
+#endif // RAYBIBLE_SIMD_SCAN_H
@@ -0,0 +1,90 @@
+#include "task_scheduler.h"
+#include <algorithm>
+
+TaskScheduler::TaskScheduler(int n) {
+    n = std::max(n, 2);
+    lanes[(int)TaskClass::Interactive].limit = n;
+    for (int c = 1; c < (int)TaskClass::Count; c++) lanes[c].limit = 1; // One of each kind; growth runs in order anyway
+    backgroundLimit = n - 1;
+    for (int i = 0; i < n; i++) workers.emplace_back(&TaskScheduler::WorkerLoop, this);
+}
+
+TaskScheduler::~TaskScheduler() { Stop(); }
+
+CancelToken TaskScheduler::Submit(TaskClass c, Task task, bool supersede) {
+    Entry e{std::move(task), CancelToken(), std::chrono::steady_clock::now()};
+    CancelToken token = e.token;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (quit) { token.Cancel(); return token; }
+        Lane& l = lanes[(int)c];
+        if (supersede) CancelLocked(l);
+        l.queue.push_back(std::move(e));
+    }
+    cv.notify_one();
+    return token;
+}
+
+void TaskScheduler::CancelLocked(Lane& l) {
+    for (auto& e : l.queue) e.token.Cancel();
+    l.cancelled += (long)l.queue.size();
+    l.queue.clear();
+    for (auto& t : l.running) t.Cancel();
+}
+
+void TaskScheduler::Cancel(TaskClass c) {
+    std::lock_guard<std::mutex> lock(mtx);
+    CancelLocked(lanes[(int)c]);
+}
+
+void TaskScheduler::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (quit) return;
+        quit = true;
+        for (auto& l : lanes) CancelLocked(l);
+    }
+    cv.notify_all();
+    for (auto& t : workers) if (t.joinable()) t.join();
+}
+
+TaskScheduler::Lane* TaskScheduler::Pick() {
+    for (auto& l : lanes) {
+        bool interactive = &l == &lanes[(int)TaskClass::Interactive];
+        if (!l.queue.empty() && (int)l.running.size() < l.limit && (interactive || background < backgroundLimit)) return &l;
+    }
+    return nullptr;
+}
+
+void TaskScheduler::WorkerLoop() {
+    std::unique_lock<std::mutex> lock(mtx);
+    for (;;) {
+        Lane* l = nullptr;
+        cv.wait(lock, [&] { return quit || (l = Pick()) != nullptr; });
+        if (quit) break;
+        Entry e = std::move(l->queue.front());
+        l->queue.pop_front();
+        double waitMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - e.queuedAt).count();
+        l->waits++; l->waitSumMs += waitMs; l->waitMaxMs = std::max(l->waitMaxMs, waitMs);
+        l->running.push_back(e.token);
+        bool bg = l != &lanes[(int)TaskClass::Interactive];
+        background += bg;
+        lock.unlock();
+        if (!e.token.Cancelled()) e.task(e.token);
+        lock.lock();
+        l->running.erase(std::find(l->running.begin(), l->running.end(), e.token));
+        background -= bg;
+        if (e.token.Cancelled()) l->cancelled++; else l->done++;
+        cv.notify_one(); // A lane at its limit may have work waiting
+    }
+}
+
+TaskClassStats TaskScheduler::Stats(TaskClass c) const {
+    std::lock_guard<std::mutex> lock(mtx);
+    const Lane& l = lanes[(int)c];
+    TaskClassStats s;
+    s.queued = (int)l.queue.size(); s.running = (int)l.running.size();
+    s.done = l.done; s.cancelled = l.cancelled;
+    s.waitAvgMs = l.waits ? l.waitSumMs / l.waits : 0; s.waitMaxMs = l.waitMaxMs;
+    return s;
+}
@@ -0,0 +1,72 @@
+#pragma once
+#ifndef RAYBIBLE_TASK_SCHEDULER_H
+#define RAYBIBLE_TASK_SCHEDULER_H
+
+#include <functional>
+#include <memory>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+
+// Highest priority first
+enum class TaskClass { Interactive, Growth, Prefetch, Search, Count };
+
+// Shared flag a task polls at safe points; cancelling never interrupts it, so work that
+// publishes results checks the token under the lock it publishes with
+class CancelToken {
+    std::shared_ptr<std::atomic<bool>> flag = std::make_shared<std::atomic<bool>>(false);
+public:
+    bool Cancelled() const { return flag->load(std::memory_order_relaxed); }
+    void Cancel() const { flag->store(true, std::memory_order_relaxed); }
+    bool operator==(const CancelToken& o) const { return flag == o.flag; }
+};
+
+struct TaskClassStats {
+    int queued = 0, running = 0;
+    long done = 0, cancelled = 0; // Cancelled counts tasks dropped from the queue and ones that ran with a cancelled token
+    double waitAvgMs = 0, waitMaxMs = 0; // Submit to start
+};
+
+// A few workers fed from one queue per class. A free worker takes the oldest task of the
+// highest class that is below its concurrency limit; the limits leave one worker that
+// only Interactive work can use, so navigation never queues behind a search or a batch
+// of prefetches.
+class TaskScheduler {
+public:
+    using Task = std::function<void(const CancelToken&)>;
+
+    explicit TaskScheduler(int workers = 4);
+    ~TaskScheduler();
+    // `supersede` cancels the class's queued and running tasks first: the newest wins
+    CancelToken Submit(TaskClass c, Task task, bool supersede = false);
+    void Cancel(TaskClass c);
+    void Stop(); // Cancels everything and joins the workers
+    TaskClassStats Stats(TaskClass c) const;
+
+private:
+    struct Entry { Task task; CancelToken token; std::chrono::steady_clock::time_point queuedAt; };
+    struct Lane {
+        std::deque<Entry> queue;
+        std::vector<CancelToken> running;
+        int limit = 1;
+        long done = 0, cancelled = 0, waits = 0;
+        double waitSumMs = 0, waitMaxMs = 0;
+    };
+
+    Lane lanes[(int)TaskClass::Count];
+    std::vector<std::thread> workers;
+    int background = 0, backgroundLimit = 1; // Running tasks outside Interactive, and their cap
+    mutable std::mutex mtx;
+    std::condition_variable cv;
+    bool quit = false;
+
+    void CancelLocked(Lane& l); // Caller holds mtx
+    Lane* Pick();               // Caller holds mtx
+    void WorkerLoop();
+};
+
+#endif // RAYBIBLE_TASK_SCHEDULER_H
@@ -0,0 +1,91 @@
+// Times JsonReader against the find-based helpers it replaced (legacy_json.h) on full
+// chapter responses in the API's format, pulling out each verse's number and text the
+// way ParseChapter does. Both must agree on the result before anything is timed.
+// Usage: json_bench [rounds]
+
+#include "json.h"
+#include "legacy_json.h"
+#include "tagged_verses.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <utility>
+
+using VerseList = std::vector<std::pair<int, std::string>>;
+
+// A chapter response of `count` verses cycling through the tagged corpus; every fifth
+// verse carries escaped quotes and a \u escape, as other translations' texts do
+static std::string ChapterPayload(int count) {
+    size_t n = sizeof(TAGGED_VERSES) / sizeof(TAGGED_VERSES[0]);
+    std::string doc = "[";
+    for (int v = 1; v <= count; v++) {
+        if (v > 1) doc += ", ";
+        doc += "{\"pk\": " + std::to_string(100000 + v) + ", \"translation\": \"KJV\", \"book\": 19, \"chapter\": 119, \"verse\": " + std::to_string(v) + ", \"text\": \"";
+        doc += TAGGED_VERSES[(v - 1) % n];
+        if (v % 5 == 0) doc += " \\\"Selah\\\" \\u2014 amen";
+        doc += "\", \"comment\": null}";
+    }
+    return doc + "]";
+}
+
+static VerseList ParseLegacy(const std::string& doc) {
+    VerseList r;
+    for (const auto& vo : LegacyJArr(doc, "")) r.emplace_back(LegacyJInt(vo, "verse"), LegacyJStr(vo, "text"));
+    return r;
+}
+
+static VerseList ParseReader(const std::string& doc) {
+    VerseList r;
+    JsonReader j(doc);
+    if (j.Next() != JsonReader::ArrayBegin) return r;
+    while (j.Next() == JsonReader::ObjectBegin) {
+        int verse = 0; std::string text;
+        while (j.Next() == JsonReader::Key) {
+            bool isVerse = j.Str() == "verse", isText = j.Str() == "text";
+            j.Next();
+            if (isVerse) verse = (int)j.Int();
+            else if (isText) text = j.Str();
+            else j.SkipValue();
+        }
+        r.emplace_back(verse, std::move(text));
+    }
+    return r;
+}
+
+static size_t Tokenize(const std::string& doc) {
+    JsonReader j(doc);
+    size_t n = 0;
+    while (j.Next() != JsonReader::End && j.Tok() != JsonReader::Error) n += j.Str().size();
+    return n;
+}
+
+// Best of `rounds` averages of `reps` calls, in microseconds per call
+template <class F>
+static double Time(int rounds, int reps, F&& f) {
+    double best = 1e30;
+    for (int r = 0; r < rounds; r++) {
+        auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < reps; i++) f();
+        best = std::min(best, std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count() / reps);
+    }
+    return best;
+}
+
+int main(int argc, char** argv) {
+    int rounds = argc > 1 ? std::max(atoi(argv[1]), 1) : 20;
+    size_t sink = 0;
+    printf("%-26s %10s %10s %10s   (us per chapter)\n", "", "legacy", "reader", "tokenize");
+    for (int count : {31, 176}) { // Genesis 1, Psalm 119
+        std::string doc = ChapterPayload(count);
+        VerseList want = ParseLegacy(doc), got = ParseReader(doc);
+        if (want != got || (int)got.size() != count) { printf("%d verses: parsers disagree\n", count); return 1; }
+        double legacy = Time(rounds, 50, [&] { sink += ParseLegacy(doc).size(); });
+        double reader = Time(rounds, 50, [&] { sink += ParseReader(doc).size(); });
+        double tokens = Time(rounds, 50, [&] { sink += Tokenize(doc); });
+        char name[64];
+        snprintf(name, sizeof(name), "%d verses, %zu KB", count, doc.size() / 1024);
+        printf("%-26s %10.1f %10.1f %10.1f\n", name, legacy, reader, tokens);
+    }
+    return sink == 0; // Never true; stops the calls being optimized away
+}
@@ -0,0 +1,117 @@
+// JsonReader: string escapes, \uXXXX surrogate pairs (what the old find-based helpers
+// got wrong), lone and invalid surrogates, and the token stream of a chapter response.
+
+#include "json.h"
+#include "simd_scan.h"
+#include "legacy_json.h"
+#include <cstdio>
+
+static int failures = 0;
+
+#define CHECK(cond) do { if (!(cond)) { printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+static std::string Hex(const std::string& s) {
+    std::string r;
+    char b[4];
+    for (unsigned char c : s) { snprintf(b, sizeof(b), "%02X ", c); r += b; }
+    return r;
+}
+
+static void CheckEq(const std::string& got, const std::string& want, const char* what, int line) {
+    if (got == want) return;
+    printf("%s:%d: %s\n  got:  %s\n  want: %s\n", __FILE__, line, what, Hex(got).c_str(), Hex(want).c_str());
+    failures++;
+}
+#define CHECK_EQ(got, want) CheckEq((got), (want), #got, __LINE__)
+
+static const std::string BAD = "<error>";
+
+// The decoded value of one JSON string literal (quotes included in `literal`)
+static std::string Decode(const std::string& literal) {
+    std::string doc = "[" + literal + "]";
+    JsonReader j(doc);
+    if (j.Next() != JsonReader::ArrayBegin || j.Next() != JsonReader::String) return BAD;
+    std::string s(j.Str());
+    return j.Next() == JsonReader::ArrayEnd ? s : BAD;
+}
+
+static void Escapes() {
+    CHECK_EQ(Decode(R"("plain")"), "plain");
+    CHECK_EQ(Decode(R"("a\"b\\c\/d\n\t\r\b\f")"), "a\"b\\c/d\n\t\r\b\f");
+    CHECK_EQ(Decode(R"("\q")"), "\\q"); // Unknown escapes are kept as written
+    CHECK_EQ(Decode(R"("A\u00e9\u2014\uFFFF")"), "A\xC3\xA9\xE2\x80\x94\xEF\xBF\xBF");
+
+    std::string doc = R"(["view", "esc\u0041ped"])";
+    JsonReader j(doc);
+    j.Next(); j.Next();
+    CHECK(!j.Escaped() && j.Str().data() == doc.data() + 2); // Unescaped strings are views into the document
+    j.Next();
+    CHECK(j.Escaped() && j.Str() == "escAped");
+}
+
+static const std::string REPLACEMENT = "\xEF\xBF\xBD"; // U+FFFD
+
+static void Surrogates() {
+    // Pairs combine into one 4-byte UTF-8 sequence, whatever the hex case
+    CHECK_EQ(Decode(R"("\ud83d\ude00")"), "\xF0\x9F\x98\x80"); // U+1F600
+    CHECK_EQ(Decode(R"("\uD834\uDD1E")"), "\xF0\x9D\x84\x9E"); // U+1D11E
+    CHECK_EQ(Decode(R"("\udbff\udfff")"), "\xF4\x8F\xBF\xBF"); // U+10FFFF, the last code point
+    CHECK_EQ(Decode(R"("\ud800\udc00")"), "\xF0\x90\x80\x80"); // U+10000, the first
+    CHECK_EQ(Decode(R"("a\ud83d\ude00b")"), "a\xF0\x9F\x98\x80" "b");
+    // The old helpers encoded each half on its own: six bytes of invalid UTF-8
+    CHECK_EQ(LegacyJStr(R"({"t": "\ud83d\ude00"})", "t"), "\xED\xA0\xBD\xED\xB8\x80");
+
+    // Lone or misordered halves become U+FFFD; what follows is decoded as usual
+    CHECK_EQ(Decode(R"("\ud83d")"), REPLACEMENT);                      // High at the end
+    CHECK_EQ(Decode(R"("\ud83dx")"), REPLACEMENT + "x");               // High before plain text
+    CHECK_EQ(Decode(R"("\ud83d\n")"), REPLACEMENT + "\n");             // High before another escape
+    CHECK_EQ(Decode(R"("\ud83d\u0041")"), REPLACEMENT + "A");          // High before a non-surrogate
+    CHECK_EQ(Decode(R"("\ud83d\ud83d\ude00")"), REPLACEMENT + "\xF0\x9F\x98\x80"); // Two highs, then a low
+    CHECK_EQ(Decode(R"("\ude00")"), REPLACEMENT);                      // Lone low
+    CHECK_EQ(Decode(R"("\ude00\ud83d")"), REPLACEMENT + REPLACEMENT);  // Low before high
+
+    // Malformed \u escapes fail the document instead of guessing
+    CHECK(Decode(R"("\u12G4")") == BAD);
+    CHECK(Decode(R"("\u12")") == BAD);
+    CHECK(Decode(R"("\ud83d\uZZZZ")") == BAD);
+}
+
+// The shape ParseChapter walks: an array of verse objects, keys in any order
+static void ChapterTokens() {
+    std::string doc = R"([{"pk": 1, "verse": 1, "text": "In the beginning<S>7225</S>", "comment": null},
+                          {"verse": 2, "text": "And \"the\" earth", "extra": {"a": [1, {"b": true}]}, "pk": -2}])";
+    JsonReader j(doc);
+    CHECK(j.Next() == JsonReader::ArrayBegin);
+    int verses = 0;
+    while (j.Next() == JsonReader::ObjectBegin) {
+        while (j.Next() == JsonReader::Key) {
+            std::string key(j.Str());
+            j.Next();
+            if (key == "verse") CHECK(j.Tok() == JsonReader::Number && j.Int() == verses + 1);
+            else if (key == "pk") CHECK(j.Int() == (verses ? -2 : 1));
+            else if (key == "text") CHECK(j.Str() == (verses ? "And \"the\" earth" : "In the beginning<S>7225</S>"));
+            else if (key == "comment") CHECK(j.Tok() == JsonReader::Null);
+            else CHECK(j.SkipValue() && j.Tok() == JsonReader::ObjectEnd);
+        }
+        CHECK(j.Tok() == JsonReader::ObjectEnd);
+        verses++;
+    }
+    CHECK(verses == 2 && j.Tok() == JsonReader::ArrayEnd && j.Next() == JsonReader::End);
+
+    // Truncated and mismatched documents end in Error, which is sticky
+    JsonReader cut(R"([{"verse": 1, "text": "In the)");
+    while (cut.Next() != JsonReader::Error && cut.Tok() != JsonReader::End) {}
+    CHECK(cut.Tok() == JsonReader::Error && cut.Next() == JsonReader::Error);
+    JsonReader wrong("[1}");
+    wrong.Next(); wrong.Next();
+    CHECK(wrong.Next() == JsonReader::Error);
+}
+
+int main() {
+    Escapes();
+    Surrogates();
+    ChapterTokens();
+    if (failures) { printf("%d check(s) failed\n", failures); return 1; }
+    printf("json (%s scanner): all checks passed\n", ScanPath());
+    return 0;
+}
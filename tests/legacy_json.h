@@ -0,0 +1,131 @@
+#pragma once
+#ifndef RAYBIBLE_TESTS_LEGACY_JSON_H
+#define RAYBIBLE_TESTS_LEGACY_JSON_H
+
+// The find-based JSON helpers the app used before JsonReader, kept as the reference it
+// is timed against. Each lookup searches the object text for the quoted key again.
+
+#include <string>
+#include <vector>
+
+inline size_t LegacySkipWS(const std::string& s, size_t p) {
+    while (p < s.size() && (s[p] == ' ' || s[p] == '\t' || s[p] == '\n' || s[p] == '\r')) p++;
+    return p;
+}
+
+inline size_t LegacyFindKey(const std::string& j, const std::string& k) {
+    std::string sk = "\"" + k + "\"";
+    size_t p = 0;
+    while ((p = j.find(sk, p)) != std::string::npos) {
+        size_t next = LegacySkipWS(j, p + sk.size());
+        if (next < j.size() && j[next] == ':') return next + 1;
+        p += sk.size();
+    }
+    return std::string::npos;
+}
+
+inline std::string LegacyJStr(const std::string& j, const std::string& k) {
+    size_t p = LegacyFindKey(j, k);
+    if (p == std::string::npos) return "";
+    p = LegacySkipWS(j, p);
+    if (p >= j.size() || j[p] != '\"') return "";
+    p++;
+    size_t e = p;
+    while (e < j.size()) {
+        if (j[e] == '\"' && j[e-1] != '\\') break;
+        e++;
+    }
+    if (e >= j.size()) return "";
+    std::string r = j.substr(p, e - p);
+    size_t pos = 0;
+    while ((pos = r.find("\\n", pos)) != std::string::npos) { r.replace(pos, 2, " "); pos += 1; }
+    pos = 0;
+    while ((pos = r.find("\\\"", pos)) != std::string::npos) { r.replace(pos, 2, "\""); pos += 1; }
+    
+    // Decode \uXXXX
+    pos = 0;
+    while ((pos = r.find("\\u", pos)) != std::string::npos) {
+        if (pos + 5 < r.size()) {
+            try {
+                int code = std::stoi(r.substr(pos + 2, 4), nullptr, 16);
+                std::string utf8;
+                if (code <= 0x7F) utf8 += (char)code;
+                else if (code <= 0x7FF) { utf8 += (char)(0xC0 | (code >> 6)); utf8 += (char)(0x80 | (code & 0x3F)); }
+                else { utf8 += (char)(0xE0 | (code >> 12)); utf8 += (char)(0x80 | ((code >> 6) & 0x3F)); utf8 += (char)(0x80 | (code & 0x3F)); }
+                r.replace(pos, 6, utf8);
+                pos += utf8.size();
+            } catch (...) { pos += 2; }
+        } else pos += 2;
+    }
+    return r;
+}
+
+inline int LegacyJInt(const std::string& j, const std::string& k) {
+    size_t p = LegacyFindKey(j, k);
+    if (p == std::string::npos) return 0;
+    p = LegacySkipWS(j, p);
+    size_t e = j.find_first_of(",}] \t\n\r", p);
+    if (e == std::string::npos) return 0;
+    try { return std::stoi(j.substr(p, e - p)); } catch (...) { return 0; }
+}
+
+inline std::vector<std::string> LegacyJArr(const std::string& j, const std::string& k) {
+    std::vector<std::string> r;
+    size_t p = 0;
+    if (!k.empty()) {
+        p = LegacyFindKey(j, k);
+        if (p == std::string::npos) return r;
+        p = LegacySkipWS(j, p);
+    } else {
+        p = LegacySkipWS(j, 0);
+    }
+    
+    if (p >= j.size() || j[p] != '[') return r;
+    p++;
+    
+    int depth = 1;
+    size_t e = p;
+    bool inStr = false;
+    while (e < j.size() && depth > 0) {
+        if (j[e] == '\"' && (e == 0 || j[e-1] != '\\')) inStr = !inStr;
+        if (!inStr) {
+            if (j[e] == '[') depth++;
+            else if (j[e] == ']') {
+                depth--;
+                if (depth == 0) break;
+            }
+        }
+        e++;
+    }
+    if (e >= j.size()) return r;
+    std::string a = j.substr(p, e - p);
+
+    size_t s = 0;
+    while (s < a.size()) {
+        size_t start = a.find('{', s);
+        if (start == std::string::npos) break;
+        
+        int objDepth = 0;
+        size_t cur = start;
+        bool objInStr = false;
+        while (cur < a.size()) {
+            if (a[cur] == '\"' && (cur == 0 || a[cur-1] != '\\')) objInStr = !objInStr;
+            if (!objInStr) {
+                if (a[cur] == '{') objDepth++;
+                else if (a[cur] == '}') {
+                    objDepth--;
+                    if (objDepth == 0) break;
+                }
+            }
+            cur++;
+        }
+        
+        if (cur < a.size()) {
+            r.push_back(a.substr(start, cur - start + 1));
+            s = cur + 1;
+        } else break;
+    }
+    return r;
+}
+
+#endif // RAYBIBLE_TESTS_LEGACY_JSON_H
@@ -0,0 +1,75 @@
+#pragma once
+#ifndef RAYBIBLE_TESTS_LEGACY_MARKUP_H
+#define RAYBIBLE_TESTS_LEGACY_MARKUP_H
+
+// The clean-up the app shipped with before markup.cpp, kept as the reference the new
+// single pass is checked and timed against: StripTags as it was, and the polish
+// FetchFromAPI ran on each verse afterwards.
+
+#include <string>
+
+inline std::string LegacyStripTags(const std::string& s) {
+    if (s.empty()) return "";
+    std::string r = s;
+
+    // 1. Decode HTML entities
+    auto replaceAll = [&](const std::string& from, const std::string& to) {
+        size_t p = 0;
+        while ((p = r.find(from, p)) != std::string::npos) {
+            r.replace(p, from.size(), to);
+            p += to.size();
+        }
+    };
+    replaceAll("&lt;", "<"); replaceAll("&gt;", ">"); replaceAll("&amp;", "&"); replaceAll("&quot;", "\"");
+
+    // 2. Remove Strong's tags and their numeric content: <S>3068</S> or <S 3068>
+    std::string finalStr;
+    bool skippingStrong = false;
+    bool inTag = false;
+    std::string currentTag;
+    for (size_t i = 0; i < r.size(); ++i) {
+        char c = r[i];
+        if (c == '<') {
+            inTag = true;
+            currentTag = "";
+        } else if (c == '>') {
+            inTag = false;
+            if (currentTag == "S" || currentTag == "s" || (currentTag.size() > 1 && (currentTag[0] == 'S' || currentTag[0] == 's'))) {
+                skippingStrong = true;
+            } else if (currentTag == "/S" || currentTag == "/s") {
+                skippingStrong = false;
+            }
+        } else if (inTag) {
+            currentTag += c;
+        } else if (!skippingStrong) {
+            finalStr += c;
+        }
+    }
+
+    // 3. Any remaining tags
+    std::string cleaned;
+    bool in = false;
+    for (char c : finalStr) {
+        if (c == '<') in = true;
+        else if (c == '>') in = false;
+        else if (!in) cleaned += c;
+    }
+
+    size_t pos = 0;
+    while ((pos = cleaned.find("  ", pos)) != std::string::npos) { cleaned.replace(pos, 2, " "); }
+    if (!cleaned.empty() && cleaned[0] == ' ') cleaned.erase(0, 1);
+    return cleaned;
+}
+
+inline std::string LegacyVerseText(const std::string& raw) {
+    std::string text = LegacyStripTags(raw);
+    size_t p = 0;
+    while ((p = text.find('\n', p)) != std::string::npos) { text.replace(p, 1, " "); }
+    p = 0;
+    while ((p = text.find("  ", p)) != std::string::npos) { text.replace(p, 2, " "); }
+    text.erase(0, text.find_first_not_of(" \t\r"));
+    text.erase(text.find_last_not_of(" \t\r") + 1);
+    return text;
+}
+
+#endif // RAYBIBLE_TESTS_LEGACY_MARKUP_H
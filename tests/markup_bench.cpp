@@ -0,0 +1,50 @@
+// Times the verse clean-up against the code it replaced (legacy_markup.h): per verse over
+// the tagged corpus, a whole chapter's worth in one string, and a long run of spaces.
+// Usage: markup_bench [rounds]
+
+#include "markup.h"
+#include "legacy_markup.h"
+#include "tagged_verses.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+
+// Best of `rounds` averages of `reps` calls, in microseconds per call
+template <class F>
+static double Time(int rounds, int reps, F&& f) {
+    double best = 1e30;
+    for (int r = 0; r < rounds; r++) {
+        auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < reps; i++) f();
+        best = std::min(best, std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count() / reps);
+    }
+    return best;
+}
+
+static size_t sink = 0; // Keeps the results alive
+
+static void Row(const char* name, int rounds, int reps, const std::string& input) {
+    double legacy = Time(rounds, reps, [&] { sink += LegacyVerseText(input).size(); });
+    double strip = Time(rounds, reps, [&] { sink += StripTags(input).size(); });
+    std::vector<char> out; std::vector<StrongsTag> tags;
+    double clean = Time(rounds, reps, [&] { out.clear(); tags.clear(); sink += CleanVerseText(input, out, tags); });
+    printf("%-28s %10.2f %10.2f %10.2f\n", name, legacy, strip, clean);
+}
+
+int main(int argc, char** argv) {
+    int rounds = argc > 1 ? std::max(atoi(argv[1]), 1) : 20;
+    std::string chapter, spaces = "a" + std::string(20000, ' ') + "b";
+    size_t verses = sizeof(TAGGED_VERSES) / sizeof(TAGGED_VERSES[0]);
+    while (chapter.size() < 32 * 1024) for (const char* v : TAGGED_VERSES) { chapter += v; chapter += ' '; }
+
+    printf("%-28s %10s %10s %10s   (us per call)\n", "", "legacy", "StripTags", "CleanVerse");
+    double legacy = Time(rounds, 200, [&] { for (const char* v : TAGGED_VERSES) sink += LegacyVerseText(v).size(); }) / verses;
+    double strip = Time(rounds, 200, [&] { for (const char* v : TAGGED_VERSES) sink += StripTags(v).size(); }) / verses;
+    std::vector<char> out; std::vector<StrongsTag> tags;
+    double clean = Time(rounds, 200, [&] { out.clear(); tags.clear(); for (const char* v : TAGGED_VERSES) sink += CleanVerseText(v, out, tags); }) / verses;
+    printf("%-28s %10.2f %10.2f %10.2f\n", "per verse", legacy, strip, clean);
+    Row("32 KiB of verses, one string", rounds, 20, chapter);
+    Row("20,000-space run", rounds, 20, spaces);
+    return sink == 0; // Never true; stops the calls being optimized away
+}
@@ -0,0 +1,99 @@
+// StripTags and CleanVerseText against the clean-up they replaced (legacy_markup.h) on
+// real tagged verses, and the cases where they differ from it on purpose.
+
+#include "markup.h"
+#include "simd_scan.h"
+#include "legacy_markup.h"
+#include "tagged_verses.h"
+#include <cstdio>
+
+static int failures = 0;
+
+#define CHECK(cond) do { if (!(cond)) { printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); failures++; } } while (0)
+
+static void CheckEq(const std::string& got, const std::string& want, const char* what, int line) {
+    if (got == want) return;
+    printf("%s:%d: %s\n  got:  [%s]\n  want: [%s]\n", __FILE__, line, what, got.c_str(), want.c_str());
+    failures++;
+}
+#define CHECK_EQ(got, want) CheckEq((got), (want), #got, __LINE__)
+
+static std::string Clean(std::string_view raw, std::vector<StrongsTag>* tagsOut = nullptr) {
+    std::vector<char> out; std::vector<StrongsTag> tags;
+    size_t len = CleanVerseText(raw, out, tags);
+    if (tagsOut) *tagsOut = tags;
+    return std::string(out.data(), len);
+}
+
+// Both cleaners give what FetchFromAPI used to store for every verse of the corpus
+static void Equivalence() {
+    for (const char* raw : TAGGED_VERSES) {
+        std::string want = LegacyVerseText(raw);
+        CHECK_EQ(StripTags(raw), want);
+        CHECK_EQ(Clean(raw), want);
+    }
+}
+
+static void Tags() {
+    std::vector<StrongsTag> tags;
+    std::string text = Clean(TAGGED_VERSES[0], &tags);
+    CHECK_EQ(text, "In the beginning God created the heaven and the earth.");
+    const uint32_t numbers[] = {7225, 430, 1254, 853, 8064, 853, 776};
+    CHECK(tags.size() == 7);
+    for (size_t i = 0; i < tags.size() && i < 7; i++) CHECK(tags[i].number == numbers[i]);
+    // Anchored just after the word the number belongs to
+    CHECK(!tags.empty() && text.compare(0, tags[0].pos, "In the beginning") == 0);
+    CHECK(tags.size() == 7 && text.compare(0, tags[6].pos, "In the beginning God created the heaven and the earth") == 0);
+
+    // Verses appended to one arena keep their positions relative to their own start
+    std::vector<char> out; std::vector<StrongsTag> all;
+    size_t first = CleanVerseText(TAGGED_VERSES[2], out, all);
+    size_t tagsBefore = all.size();
+    size_t second = CleanVerseText(TAGGED_VERSES[0], out, all);
+    CHECK(out.size() == first + second);
+    CHECK(all.size() == tagsBefore + 7 && all[tagsBefore].pos == tags[0].pos);
+
+    // No number, no tag; the markup still goes
+    CHECK_EQ(Clean("word<S></S> and<S>x</S> more", &tags), "word and more");
+    CHECK(tags.empty());
+}
+
+// Where the single pass parts from the old code on purpose
+static void Differences() {
+    // Escaped markup is text that happens to look like a tag; the old code decoded it
+    // first and then stripped it along with the real tags. Lexicon definitions included.
+    const char* escaped = "x &lt;S&gt;123&lt;/S&gt; y &amp; z";
+    CHECK_EQ(StripTags(escaped), "x <S>123</S> y & z");
+    CHECK_EQ(LegacyStripTags(escaped), "x y & z");
+    std::vector<StrongsTag> tags;
+    CHECK_EQ(Clean(escaped, &tags), "x <S>123</S> y & z");
+    CHECK(tags.empty());
+
+    // Both ends are trimmed of spaces, tabs and carriage returns, as FetchFromAPI did
+    // for verses; tags in the trimmed lead-in move with the text
+    const char* padded = "\t\r In the beginning<S>7225</S> \r\n";
+    CHECK_EQ(Clean(padded, &tags), "In the beginning");
+    CHECK(tags.size() == 1 && tags[0].pos == 16);
+    CHECK_EQ(Clean("\t<S>1</S>\rword", &tags), "word");
+    CHECK(tags.size() == 1 && tags[0].pos == 0);
+    CHECK_EQ(LegacyVerseText(padded), "In the beginning");
+    // StripTags now trims and turns newlines into spaces too; the old one left both alone
+    CHECK_EQ(StripTags("shepherd \n"), "shepherd");
+    CHECK_EQ(LegacyStripTags("shepherd \n"), "shepherd \n");
+    CHECK_EQ(StripTags("one\ntwo"), "one two");
+
+    // The inline <S 3068> form drops only the tag; the old code skipped to the next </S>
+    CHECK_EQ(StripTags("the LORD<S 3068> said unto Moses"), "the LORD said unto Moses");
+    CHECK_EQ(LegacyStripTags("the LORD<S 3068> said unto Moses"), "the LORD");
+    CHECK_EQ(Clean("the LORD<S 3068> said", &tags), "the LORD said");
+    CHECK(tags.size() == 1 && tags[0].number == 3068 && tags[0].pos == 8);
+}
+
+int main() {
+    Equivalence();
+    Tags();
+    Differences();
+    if (failures) { printf("%d check(s) failed\n", failures); return 1; }
+    printf("markup (%s scanner): all checks passed\n", ScanPath());
+    return 0;
+}
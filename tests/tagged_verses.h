@@ -0,0 +1,33 @@
+#pragma once
+#ifndef RAYBIBLE_TESTS_TAGGED_VERSES_H
+#define RAYBIBLE_TESTS_TAGGED_VERSES_H
+
+// Verse texts as the API serves them for a Strong's-tagged translation (KJV): numbers
+// after the word they annotate, verb-parsing codes as a second tag, italics for supplied
+// words, the odd line break. Plus lexicon definitions, which go through StripTags too.
+
+static const char* const TAGGED_VERSES[] = {
+    // Genesis 1:1-5
+    "In the beginning<S>7225</S> God<S>430</S> created<S>1254</S> <S>853</S> the heaven<S>8064</S> and<S>853</S> the earth<S>776</S>.",
+    "And the earth<S>776</S> was<S>1961</S> without form<S>8414</S>, and void<S>922</S>; and darkness<S>2822</S> <i>was</i> upon the face<S>6440</S> of the deep<S>8415</S>. And the Spirit<S>7307</S> of God<S>430</S> moved<S>7363</S> upon the face<S>6440</S> of the waters<S>4325</S>.",
+    "And God<S>430</S> said<S>559</S>, Let there be<S>1961</S> light<S>216</S>: and there was<S>1961</S> light<S>216</S>.",
+    "And God<S>430</S> saw<S>7200</S> <S>853</S> the light<S>216</S>, that<S>3588</S> <i>it was</i> good<S>2896</S>: and God<S>430</S> divided<S>914</S> <S>996</S> the light<S>216</S> from<S>996</S> the darkness<S>2822</S>.",
+    "And God<S>430</S> called<S>7121</S> the light<S>216</S> Day<S>3117</S>, and the darkness<S>2822</S> he called<S>7121</S> Night<S>3915</S>. And the evening<S>6153</S> and the morning<S>1242</S> were<S>1961</S> the first<S>259</S> day<S>3117</S>.",
+    // Psalm 23:1-2, with the superscription's break
+    "<br/>A Psalm<S>4210</S> of David<S>1732</S>.<br/> The LORD<S>3068</S> <i>is</i> my shepherd<S>7462</S>; I shall not want<S>2637</S>.",
+    "He maketh me to lie down<S>7257</S> in green<S>1877</S> pastures<S>4999</S>: he leadeth<S>5095</S> me beside the still<S>4496</S> waters<S>4325</S>.",
+    // John 1:1-3
+    "In<S>1722</S> the beginning<S>746</S> was<S>2258</S> <S>5713</S> the Word<S>3056</S>, and<S>2532</S> the Word<S>3056</S> was<S>2258</S> <S>5713</S> with<S>4314</S> God<S>2316</S>, and<S>2532</S> the Word<S>3056</S> was<S>2258</S> <S>5713</S> God<S>2316</S>.",
+    "The same<S>3778</S> was<S>2258</S> <S>5713</S> in<S>1722</S> the beginning<S>746</S> with<S>4314</S> God<S>2316</S>.",
+    "All things<S>3956</S> were made<S>1096</S> <S>5633</S> by<S>1223</S> him<S>846</S>; and<S>2532</S> without<S>5565</S> him<S>846</S> was<S>1096</S> <S>0</S> not<S>3761</S> any thing<S>1520</S> made<S>1096</S> <S>5633</S> that<S>3739</S> was made<S>1096</S> <S>5754</S>.",
+    // John 3:16
+    "For<S>1063</S> God<S>2316</S> so<S>3779</S> loved<S>25</S> <S>5656</S> the world<S>2889</S>, that<S>5620</S> he gave<S>1325</S> <S>5656</S> his<S>846</S> only begotten<S>3439</S> Son<S>5207</S>, that<S>2443</S> whosoever<S>3956</S> believeth<S>4100</S> <S>5723</S> in<S>1519</S> him<S>846</S> should<S>622</S> <S>0</S> not<S>3361</S> perish<S>622</S> <S>5643</S>, but<S>235</S> have<S>2192</S> <S>5725</S> everlasting<S>166</S> life<S>2222</S>.",
+    // Matthew 4:4, quoted speech
+    "But<S>1161</S> he answered<S>611</S> <S>5679</S> and said<S>2036</S> <S>5627</S>, It is written<S>1125</S> <S>5769</S>, Man<S>444</S> shall<S>2198</S> <S>0</S> not<S>3756</S> live<S>2198</S> <S>5695</S> by<S>1909</S> bread<S>740</S> alone<S>3441</S>, but<S>235</S> by<S>1909</S> every<S>3956</S> word<S>4487</S> that proceedeth<S>1607</S> <S>5740</S> out of<S>1223</S> the mouth<S>4750</S> of God<S>2316</S>.",
+    // Lexicon definitions
+    "<b>1.</b> beginning, chief<br><b>2.</b> first, in place, time, order or rank (specifically, a firstfruit)",
+    "love (in a social or moral sense)<br/>Compare <S>5368</S>.",
+    "Jehovah = &quot;the existing One&quot;<br>the proper name of the one true God",
+};
+
+#endif // RAYBIBLE_TESTS_TAGGED_VERSES_H
@@ -0,0 +1,277 @@
+#include "transport.h"
+#include "http_client.h"
+#include "utils.h"
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <cctype>
+
+#ifdef _WIN32
+    #include <winsock2.h>
+    #include <ws2tcpip.h>
+    #define CloseSocket closesocket
+    #define SHUT_RDWR SD_BOTH
+    #pragma comment(lib, "ws2_32.lib")
+#else
+    #include <sys/socket.h>
+    #include <netinet/in.h>
+    #include <netinet/tcp.h>
+    #include <arpa/inet.h>
+    #include <unistd.h>
+    #define CloseSocket close
+#endif
+
+Transport* g_transport = &g_http;
+
+std::string Transport::Get(const std::string& url) {
+    HttpResponse r = Request(url);
+    return r.status ? std::move(r.body) : std::string();
+}
+
+void Transport::GetMany(const std::vector<std::string>& urls, const std::function<void(size_t, HttpResponse)>& done) {
+    for (size_t i = 0; i < urls.size(); i++) done(i, Request(urls[i]));
+}
+
+// --- Fixtures ---
+
+static std::string UrlPath(const std::string& url) {
+    size_t s = url.find("://");
+    return s == std::string::npos ? url : url.substr(std::min(url.find('/', s + 3), url.size()));
+}
+
+std::string FixtureFile(const std::string& dir, const std::string& url) {
+    std::string name;
+    for (char c : UrlPath(url)) {
+        bool plain = isalnum((unsigned char)c) || c == '-' || c == '.';
+        if (plain) name += c;
+        else if (!name.empty() && name.back() != '_') name += '_';
+    }
+    while (!name.empty() && name.back() == '_') name.pop_back();
+    return dir + "/" + (name.empty() ? "index" : name) + ".http";
+}
+
+bool LoadFixture(const std::string& file, HttpResponse& out) {
+    std::string c = ReadFile(file);
+    size_t nl = c.find('\n'), sp = c.find(' ');
+    if (nl == std::string::npos || sp > nl) return false;
+    out.status = atol(c.c_str());
+    out.etag = c.substr(sp + 1, nl - sp - 1);
+    out.body = c.substr(nl + 1);
+    return out.status > 0;
+}
+
+bool SaveFixture(const std::string& file, const HttpResponse& r) {
+    return WriteFileAtomic(file, std::to_string(r.status) + " " + r.etag + "\n" + r.body);
+}
+
+// If-None-Match outranks If-Modified-Since, as in HTTP: a validator that does not match
+// means changed, whatever the dates say
+static bool NotModified(const HttpResponse& r, const std::string& etag, time_t since, time_t modified) {
+    if (r.status != 200) return false;
+    if (!etag.empty()) return etag == r.etag;
+    return since > 0 && modified > 0 && modified <= since;
+}
+
+// RFC 1123 dates ("Sun, 06 Nov 1994 08:49:37 GMT"), the form clients send; 0 if unreadable
+static time_t ParseHttpDate(const std::string& s) {
+    static const char* MONTHS = "JanFebMarAprMayJunJulAugSepOctNovDec";
+    char mon[4] = {};
+    int d, y, hh, mm, ss;
+    if (sscanf(s.c_str(), "%*3s, %d %3s %d %d:%d:%d", &d, mon, &y, &hh, &mm, &ss) != 6) return 0;
+    const char* m = strstr(MONTHS, mon);
+    if (!m || strlen(mon) != 3 || (m - MONTHS) % 3) return 0;
+    int month = (int)(m - MONTHS) / 3 + 1;
+    // Days since 1970-01-01 in the proleptic Gregorian calendar, without timegm (not on Windows)
+    int yy = y - (month <= 2), era = (yy >= 0 ? yy : yy - 399) / 400, yoe = yy - era * 400;
+    int doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + d - 1, doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    long long days = (long long)era * 146097 + doe - 719468;
+    return (time_t)(days * 86400 + hh * 3600 + mm * 60 + ss);
+}
+
+void FixtureTransport::Open(const std::string& d, Transport* recordFrom) {
+    dir = d; source = recordFrom;
+    MakeDir(dir);
+}
+
+HttpResponse FixtureTransport::Request(const std::string& url, const std::string& etag, time_t since) {
+    std::string file = FixtureFile(dir, url);
+    HttpResponse r;
+    if (source) {
+        r = source->Request(url); // Unconditional, so the fixture always holds a body
+        if (r.status) SaveFixture(file, r);
+    } else if (!LoadFixture(file, r)) {
+        r = {}; r.status = 404;
+        return r;
+    }
+    if (NotModified(r, etag, since, GetFileTime(file))) { r.status = 304; r.body.clear(); }
+    return r;
+}
+
+// --- Stub server ---
+
+StubServer::~StubServer() { Stop(); }
+
+bool StubServer::Start(const std::string& fixtureDir, int latency, float errors) {
+    if (running) return true;
+#ifdef _WIN32
+    WSADATA wsa;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) return false;
+#endif
+    dir = fixtureDir; latencyMs = latency; errorRate = errors;
+    intptr_t ls = (intptr_t)socket(AF_INET, SOCK_STREAM, 0);
+    if (ls == -1) return false;
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET; addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK); addr.sin_port = 0; // Any free port
+    socklen_t len = sizeof(addr);
+    if (bind(ls, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(ls, 64) != 0 || getsockname(ls, (sockaddr*)&addr, &len) != 0) { CloseSocket(ls); return false; }
+    listener = ls; port = ntohs(addr.sin_port);
+    running = true;
+    acceptor = std::thread(&StubServer::AcceptLoop, this);
+    return true;
+}
+
+void StubServer::Stop() {
+    if (!running.exchange(false)) return;
+    // A throwaway connection wakes accept(), which then sees running is false
+    intptr_t poke = (intptr_t)socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET; addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK); addr.sin_port = htons((unsigned short)port);
+    if (poke != -1) { connect(poke, (sockaddr*)&addr, sizeof(addr)); CloseSocket(poke); }
+    if (acceptor.joinable()) acceptor.join();
+    CloseSocket(listener); listener = -1;
+    std::vector<std::thread> done;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        for (intptr_t s : socks) shutdown(s, SHUT_RDWR); // Wakes recv() in each Serve
+        done.swap(conns);
+    }
+    for (auto& t : done) t.join();
+    finished.clear(); // Only now are all of them in
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+void StubServer::AcceptLoop() {
+    while (running) {
+        intptr_t s = (intptr_t)accept(listener, nullptr, nullptr);
+        if (s == -1) { if (!running) break; continue; }
+        if (!running) { CloseSocket(s); break; }
+        int one = 1;
+        setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char*)&one, sizeof(one)); // Responses go out in one send; no Nagle wait
+        std::lock_guard<std::mutex> lock(mtx);
+        Reap();
+        socks.push_back(s);
+        conns.emplace_back(&StubServer::Serve, this, s);
+    }
+}
+
+// A finished thread only has its socket left to close, so joining it here is brief
+void StubServer::Reap() {
+    for (std::thread::id id : finished) {
+        auto t = std::find_if(conns.begin(), conns.end(), [&](const std::thread& c) { return c.get_id() == id; });
+        if (t == conns.end()) continue;
+        t->join();
+        conns.erase(t);
+    }
+    finished.clear();
+}
+
+static bool SendAll(intptr_t s, const std::string& data) {
+    for (size_t sent = 0; sent < data.size();) {
+        int n = send(s, data.data() + sent, (int)(data.size() - sent), 0);
+        if (n <= 0) return false;
+        sent += n;
+    }
+    return true;
+}
+
+// One keep-alive connection: requests are read, answered and counted until the client
+// hangs up, an error is injected as a drop, or the server stops
+void StubServer::Serve(intptr_t s) {
+    std::minstd_rand rng{(unsigned)s ^ (unsigned)std::chrono::steady_clock::now().time_since_epoch().count()};
+    std::string in;
+    char buf[4096];
+    while (running) {
+        size_t end;
+        while ((end = in.find("\r\n\r\n")) == std::string::npos) {
+            int n = recv(s, buf, sizeof(buf), 0);
+            if (n <= 0) break;
+            in.append(buf, n);
+        }
+        if (end == std::string::npos) break;
+        std::string head = in.substr(0, end), lower = ToLower(head); // Header names are case-insensitive
+        in.erase(0, end + 4);
+        size_t pathEnd = head.compare(0, 4, "GET ") == 0 ? head.find(' ', 4) : std::string::npos; // "GET <path> HTTP/1.1"
+        if (pathEnd == std::string::npos || pathEnd == 4) {
+            SendAll(s, "HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+            break;
+        }
+        std::string path = head.substr(4, pathEnd - 4);
+        auto header = [&](const char* name) { // Value of a header, given lowercase with its colon
+            size_t h = lower.find(name);
+            if (h == std::string::npos) return std::string();
+            size_t vs = std::min(head.find_first_not_of(' ', h + strlen(name)), head.size()), ve = head.find("\r\n", vs);
+            return head.substr(vs, ve - vs);
+        };
+        std::string etag = header("\r\nif-none-match:");
+        time_t since = ParseHttpDate(header("\r\nif-modified-since:"));
+        if (latencyMs > 0) std::this_thread::sleep_for(std::chrono::milliseconds(latencyMs));
+        float roll = std::uniform_real_distribution<float>(0, 1)(rng);
+        if (roll < errorRate) {
+            injected++;
+            if (roll < errorRate / 2) break;
+            SendAll(s, "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\n\r\n");
+            continue;
+        }
+        HttpResponse r;
+        std::string file = FixtureFile(dir, path);
+        if (!LoadFixture(file, r)) r.status = 404;
+        if (NotModified(r, etag, since, GetFileTime(file))) { r.status = 304; r.body.clear(); }
+        std::string reply = "HTTP/1.1 " + std::to_string(r.status) + (r.status == 200 ? " OK" : r.status == 304 ? " Not Modified" : r.status == 404 ? " Not Found" : " Error") + "\r\nContent-Type: application/json\r\n";
+        if (!r.etag.empty()) reply += "ETag: " + r.etag + "\r\n";
+        reply += "Content-Length: " + std::to_string(r.body.size()) + "\r\n\r\n" + r.body;
+        if (!SendAll(s, reply)) break;
+        served++;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mtx); // Off the list before the descriptor can be reused
+        socks.erase(std::find(socks.begin(), socks.end(), s));
+        finished.push_back(std::this_thread::get_id());
+    }
+    CloseSocket(s);
+}
+
+// --- Loopback ---
+
+bool LoopbackTransport::Start(Transport* c, const std::string& fixtureDir, int latencyMs, float errorRate) {
+    client = c;
+    return server.Start(fixtureDir, latencyMs, errorRate);
+}
+
+std::string LoopbackTransport::Redirect(const std::string& url) const {
+    return server.BaseURL() + UrlPath(url);
+}
+
+HttpResponse LoopbackTransport::Request(const std::string& url, const std::string& etag, time_t since) {
+    return client->Request(Redirect(url), etag, since);
+}
+
+void LoopbackTransport::GetMany(const std::vector<std::string>& urls, const std::function<void(size_t, HttpResponse)>& done) {
+    std::vector<std::string> local;
+    local.reserve(urls.size());
+    for (const auto& u : urls) local.push_back(Redirect(u));
+    client->GetMany(local, done);
+}
+
+static FixtureTransport s_fixtures;
+static LoopbackTransport s_loopback;
+
+void SelectTransport(const std::string& mode, const std::string& dir, int latencyMs, float errorRate) {
+    g_transport = &g_http;
+    if (mode == "replay" || mode == "record") { s_fixtures.Open(dir, mode == "record" ? &g_http : nullptr); g_transport = &s_fixtures; }
+    else if (mode == "stub" && s_loopback.Start(&g_http, dir, latencyMs, errorRate)) g_transport = &s_loopback;
+}
@@ -0,0 +1,115 @@
+#pragma once
+#ifndef RAYBIBLE_TRANSPORT_H
+#define RAYBIBLE_TRANSPORT_H
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <cstdint>
+#include <ctime>
+
+struct HttpResponse {
+    long status = 0;  // 0 = no response at all (connection, TLS or timeout failure)
+    std::string body; // Already inflated when the server sent it gzip/deflate encoded
+    std::string etag; // Validator to send back as If-None-Match; empty if there was none
+};
+
+// Where fetches go. Everything that talks to the API goes through g_transport, so the
+// live service can be swapped for recorded fixtures or a local stub server and the fetch
+// paths measured without a network.
+class Transport {
+public:
+    virtual ~Transport() = default;
+    // GET with If-None-Match (etag) and If-Modified-Since (since) when they are given
+    virtual HttpResponse Request(const std::string& url, const std::string& etag = "", time_t since = 0) = 0;
+    // Every GET of the batch; done(i, response) runs on the calling thread in completion
+    // order. The default makes them one after another.
+    virtual void GetMany(const std::vector<std::string>& urls, const std::function<void(size_t, HttpResponse)>& done);
+    virtual bool Offline() const { return false; } // Failing fast without trying the network
+    std::string Get(const std::string& url); // Body of any response, "" when there was none
+};
+
+// --- Fixtures ---
+// One file per URL path under a directory ("/get-text/KJV/43/3/" is get-text_KJV_43_3.http):
+// a "<status> <etag>" line, then the body. The file's modification time stands in for the
+// resource's Last-Modified, so both fixture paths can answer conditional GETs with a 304:
+// by ETag when If-None-Match is sent, otherwise by If-Modified-Since.
+std::string FixtureFile(const std::string& dir, const std::string& url);
+bool LoadFixture(const std::string& file, HttpResponse& out);
+bool SaveFixture(const std::string& file, const HttpResponse& r);
+
+// Answers from fixtures only, with a 404 for anything not recorded; with `recordFrom` it
+// fetches through that transport instead and saves every response it gets
+class FixtureTransport : public Transport {
+public:
+    void Open(const std::string& dir, Transport* recordFrom = nullptr);
+    HttpResponse Request(const std::string& url, const std::string& etag = "", time_t since = 0) override;
+    bool Offline() const override { return source && source->Offline(); }
+
+private:
+    std::string dir;
+    Transport* source = nullptr;
+};
+
+// --- Stub server ---
+// Plain HTTP on 127.0.0.1 serving a fixture directory, so the real client (pool, multi,
+// retries, breaker) runs against a reproducible network. Every response is held back
+// latencyMs; errorRate of them fail, half as a 503 and half as a dropped connection.
+// Honors If-None-Match and If-Modified-Since; keeps connections alive. Anything but a well-formed GET gets a
+// 400 and the connection is closed.
+class StubServer {
+public:
+    ~StubServer();
+    bool Start(const std::string& fixtureDir, int latencyMs, float errorRate); // On a free port
+    void Stop();
+    std::string BaseURL() const { return "http://127.0.0.1:" + std::to_string(port); }
+    long Served() const { return served; }
+    long Injected() const { return injected; }
+
+private:
+    std::string dir;
+    int latencyMs = 0, port = 0;
+    float errorRate = 0;
+    intptr_t listener = -1;
+    std::atomic<bool> running{false};
+    std::atomic<long> served{0}, injected{0};
+    std::thread acceptor;
+    std::mutex mtx; // Guards the connection lists
+    std::vector<intptr_t> socks;
+    std::vector<std::thread> conns;
+    std::vector<std::thread::id> finished; // Serve threads that have returned, joined on the next accept
+
+    void AcceptLoop();
+    void Reap(); // Caller holds mtx
+    void Serve(intptr_t s);
+};
+
+// Sends every request to a StubServer it owns: the API's scheme and host are swapped for
+// the stub's, and the rest goes through `client` as usual
+class LoopbackTransport : public Transport {
+public:
+    bool Start(Transport* client, const std::string& fixtureDir, int latencyMs, float errorRate);
+    HttpResponse Request(const std::string& url, const std::string& etag = "", time_t since = 0) override;
+    void GetMany(const std::vector<std::string>& urls, const std::function<void(size_t, HttpResponse)>& done) override;
+    bool Offline() const override { return client && client->Offline(); }
+    StubServer& Server() { return server; }
+
+private:
+    StubServer server;
+    Transport* client = nullptr;
+    std::string Redirect(const std::string& url) const;
+};
+
+// Points g_transport at the transport `mode` names: "http" (the default), "replay" or
+// "record" (fixtures in `dir`), or "stub" (a loopback stub server serving `dir`). Falls
+// back to "http" if the stub cannot start.
+void SelectTransport(const std::string& mode, const std::string& dir, int latencyMs, float errorRate);
+
+extern Transport* g_transport;
+
+inline std::string HttpGet(const std::string& url) { return g_transport->Get(url); }
+
+#endif // RAYBIBLE_TRANSPORT_H
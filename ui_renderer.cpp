@@ -1,7 +1,11 @@
 #include "ui_renderer.h"
 #include "bible_logic.h"
 #include "managers.h"
+#include "downloader.h"
 #include "utils.h"
+#include "http_client.h"
+#include "lexicon.h"
+#include "prefetcher.h"
 #include <algorithm>
 #include <cstring>
 #include <sstream>
@@ -14,11 +18,11 @@ static std::string FmtBytes(long b) {
     return std::to_string(b / (1 << 20)) + " MB"; 
 }
 
-std::vector<std::string> WrapText(const std::string& text, Font font, float fontSize, float maxWidth) {
+std::vector<std::string> WrapText(std::string_view text, Font font, float fontSize, float maxWidth) {
     std::vector<std::string> lines;
     if (maxWidth <= 0) return lines;
     std::string cur;
-    std::istringstream ws(text); std::string word;
+    std::istringstream ws{std::string(text)}; std::string word;
     while (ws >> word) {
         std::string test = cur.empty() ? word : cur + " " + word;
         if (MeasureTextEx(font, test.c_str(), fontSize, 1).x > maxWidth && !cur.empty()) { lines.push_back(cur); cur = word; }
@@ -28,35 +32,31 @@ std::vector<std::string> WrapText(const std::string& text, Font font, float font
     return lines;
 }
 
-static std::vector<std::string> WrapStudyText(const std::string& raw, Font font, float fontSize, float maxWidth) {
-    std::vector<std::string> lines;
-    if (maxWidth <= 0) return lines;
-    auto getClean = [](const std::string& s) {
-        std::string r; bool in = false;
-        for (char c : s) { if (c == '<') in = true; else if (c == '>') in = false; else if (!in) r += c; }
-        return r;
-    };
-    std::string curLine, cleanCurLine;
-    std::istringstream ws(raw); std::string part;
-    while (ws >> part) {
-        std::string cleanPart = getClean(part);
-        std::string testLine = cleanCurLine.empty() ? cleanPart : cleanCurLine + " " + cleanPart;
-        float extraWidth = (float)part.size() * (fontSize * 0.1f); 
-        if (MeasureTextEx(font, testLine.c_str(), fontSize, 1).x + extraWidth > maxWidth && !curLine.empty()) {
-            lines.push_back(curLine); curLine = part; cleanCurLine = cleanPart;
-        } else { curLine = curLine.empty() ? part : curLine + " " + part; cleanCurLine = testLine; }
+// Breaks a tagged verse into lines for the study view; each line's width includes the
+// Strong's numbers drawn after its words. Returns the start offset of every line in v.text.
+static std::vector<size_t> WrapStudyText(const Verse& v, Font font, float fontSize, float maxWidth) {
+    std::vector<size_t> starts;
+    if (maxWidth <= 0) return starts;
+    std::string_view t = v.text; size_t ti = 0; float lineW = 0, spaceW = MeasureTextEx(font, " ", fontSize, 1).x;
+    for (size_t p = 0; p < t.size();) {
+        if (t[p] == ' ') { p++; continue; }
+        size_t we = t.find(' ', p); if (we == std::string::npos) we = t.size();
+        float w = MeasureTextEx(font, std::string(t.substr(p, we - p)).c_str(), fontSize, 1).x;
+        for (; ti < v.tags.size() && v.tags[ti].pos <= we; ti++) w += MeasureTextEx(font, std::to_string(v.tags[ti].number).c_str(), fontSize * 0.55f, 1).x + 3;
+        if (starts.empty() || lineW + spaceW + w > maxWidth) { starts.push_back(starts.empty() ? 0 : p); lineW = w; }
+        else lineW += spaceW + w;
+        p = we;
     }
-    if (!curLine.empty()) lines.push_back(curLine);
-    return lines;
+    return starts;
 }
 
-std::vector<Page> BuildPages(const std::deque<Chapter>& chapters, const std::deque<Chapter>& chapters2, bool parallelMode, Font font, float pageW, float pageH, float fSize, float lSpacing) {
+std::vector<Page> BuildPages(const std::deque<ChapterRef>& chapters, const std::deque<ChapterRef>& chapters2, bool parallelMode, Font font, float pageW, float pageH, float fSize, float lSpacing) {
     std::vector<Page> pages;
     if (chapters.empty()) return pages;
     const float verseGap = 14.0f, footerRoom = 50.0f, headingH = 42.0f;
     if (!parallelMode) {
         for (int ci = 0; ci < (int)chapters.size(); ci++) {
-            const Chapter& ch = chapters[ci]; if (!ch.isLoaded || ch.verses.empty()) continue;
+            const Chapter& ch = *chapters[ci]; if (!ch.isLoaded || ch.verses.empty()) continue;
             Page cur{}; cur.chapterBufIndex = ci; cur.isChapterStart = true; cur.startVerse = ch.verses[0].number;
             float usedY = headingH;
             for (int vi = 0; vi < (int)ch.verses.size(); vi++) {
@@ -70,7 +70,7 @@ std::vector<Page> BuildPages(const std::deque<Chapter>& chapters, const std::deq
         }
     } else {
         for (int ci = 0; ci < (int)chapters.size(); ci++) {
-            const Chapter& ch1 = chapters[ci]; const Chapter* ch2 = (ci < (int)chapters2.size()) ? &chapters2[ci] : nullptr;
+            const Chapter& ch1 = *chapters[ci]; const Chapter* ch2 = (ci < (int)chapters2.size()) ? chapters2[ci].get() : nullptr;
             if (!ch1.isLoaded || ch1.verses.empty()) continue;
             Page cur{}; cur.chapterBufIndex = ci; cur.isChapterStart = true; cur.startVerse = ch1.verses[0].number;
             float colW = (pageW - 80.0f) / 2.0f, usedY = headingH; size_t maxVerses = std::max(ch1.verses.size(), (ch2 && ch2->isLoaded) ? ch2->verses.size() : 0);
@@ -99,7 +99,7 @@ void DrawLogo(float x, float y, float size, Color accent, Color gold) {
 void SaveVerseImage(const Verse& v, const std::string& ref, const std::string& trans, Font font) {
     const int W = 800, H = 450; RenderTexture2D target = LoadRenderTexture(W, H); BeginTextureMode(target); ClearBackground({20, 20, 20, 255});
     DrawRectangleLinesEx({10, 10, (float)W - 20, (float)H - 20}, 3, {180, 140, 40, 255}); DrawRectangleLinesEx({20, 20, (float)W - 40, (float)H - 40}, 1, {140, 20, 20, 255});
-    float fs = 32.0f; std::string quote = "\"" + v.text + "\""; auto lines = WrapText(quote, font, fs, (float)W - 120); float totalTxtH = (float)lines.size() * (fs + 8); float ty = ((float)H - totalTxtH) / 2.0f - 30;
+    float fs = 32.0f; std::string quote = "\"" + std::string(v.text) + "\""; auto lines = WrapText(quote, font, fs, (float)W - 120); float totalTxtH = (float)lines.size() * (fs + 8); float ty = ((float)H - totalTxtH) / 2.0f - 30;
     for (const auto& line : lines) { Vector2 sz = MeasureTextEx(font, line.c_str(), fs, 1); DrawTextEx(font, line.c_str(), {((float)W - sz.x) / 2.0f, ty}, fs, 1, {245, 240, 225, 255}); ty += fs + 8; }
     std::string refStr = ref + ":" + std::to_string(v.number) + " (" + trans + ")"; Vector2 rsz = MeasureTextEx(font, refStr.c_str(), 24, 1); DrawTextEx(font, refStr.c_str(), {((float)W - rsz.x) / 2.0f, ty + 20}, 24, 1, {180, 140, 40, 255});
     DrawTextEx(font, "Divine Word", {(float)W - 140, (float)H - 45}, 18, 1, {140, 20, 20, 150}); EndTextureMode();
@@ -108,23 +108,20 @@ void SaveVerseImage(const Verse& v, const std::string& ref, const std::string& t
 
 // --- Internal Rendering ---
 
-static void DrawStudyLine(Font font, const std::string& line, float x, float y, float fSize, Color textCol, Color tagCol, AppState& s) {
-    float curX = x; bool inTag = false, inStrongs = false; std::string tagContent, word;
-    auto flushWord = [&]() { if (word.empty()) return; DrawTextEx(font, word.c_str(), {curX, y}, fSize, 1, textCol); curX += MeasureTextEx(font, word.c_str(), fSize, 1).x; word = ""; };
-    for (size_t i = 0; i < line.size(); i++) {
-        char c = line[i];
-        if (c == '<') { flushWord(); inTag = true; tagContent = ""; }
-        else if (c == '>') { inTag = false; if (tagContent == "S" || tagContent == "s") inStrongs = true; else if (tagContent == "/S" || tagContent == "/s") inStrongs = false; }
-        else if (inTag) { tagContent += c; }
-        else if (inStrongs) { std::string num; while (i < line.size() && line[i] != '<') { num += line[i]; i++; } i--; 
-            float tagFSize = fSize * 0.55f; Vector2 sz = MeasureTextEx(font, num.c_str(), tagFSize, 1); Rectangle r = {curX, y, sz.x + 2, tagFSize + 2}; bool hov = CheckCollisionPointRec(GetMousePosition(), r); DrawTextEx(font, num.c_str(), {curX, y}, tagFSize, 1, hov ? RAYWHITE : tagCol); if (hov) { strncpy(s.tooltip, "Study Word", 63); if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) { s.LookupStrongs(num); s.showSidebar = true; } } curX += sz.x + 3; }
-        else { if (c == ' ') { flushWord(); curX += MeasureTextEx(font, " ", fSize, 1).x; } else word += c; }
+// Draws v.text[begin, end) with the Strong's numbers that fall inside it as small clickable tags
+static void DrawStudyLine(Font font, const Verse& v, int bookIdx, size_t begin, size_t end, float x, float y, float fSize, Color textCol, Color tagCol, AppState& s) {
+    float curX = x; size_t cur = begin;
+    auto drawText = [&](size_t to) { if (to <= cur) return; std::string seg(v.text.substr(cur, to - cur)); DrawTextEx(font, seg.c_str(), {curX, y}, fSize, 1, textCol); curX += MeasureTextEx(font, seg.c_str(), fSize, 1).x; cur = to; };
+    auto it = std::lower_bound(v.tags.begin(), v.tags.end(), begin, [](const StrongsTag& t, size_t p) { return t.pos < p; });
+    for (; it != v.tags.end() && (it->pos < end || (end == v.text.size() && it->pos == end)); ++it) {
+        drawText(it->pos);
+        std::string num = std::to_string(it->number); float tagFSize = fSize * 0.55f; Vector2 sz = MeasureTextEx(font, num.c_str(), tagFSize, 1); Rectangle r = {curX, y, sz.x + 2, tagFSize + 2}; bool hov = CheckCollisionPointRec(GetMousePosition(), r); DrawTextEx(font, num.c_str(), {curX, y}, tagFSize, 1, hov ? RAYWHITE : tagCol); if (hov) { strncpy(s.tooltip, "Study Word", 63); if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) { s.LookupStrongs(bookIdx, it->number); s.showSidebar = true; } } curX += sz.x + 3;
     }
-    flushWord();
+    drawText(end);
 }
 
-static void DrawVerseText(Font font, const Verse& v, float x, float& y, float maxW, float fSize, float lSpacing, float vGap, Color textCol, Color numCol, bool hovered, const std::vector<SearchMatch>& matches, Color hlCol, AppState& s, const std::string& book, int chapter, const std::string& trans) {
-    auto* vd = g_study.Get(book, chapter, v.number, trans);
+static void DrawVerseText(Font font, const Verse& v, float x, float& y, float maxW, float fSize, float lSpacing, float vGap, Color textCol, Color numCol, bool hovered, const std::vector<SearchMatch>& matches, Color hlCol, AppState& s, const Chapter& ch) {
+    auto* vd = g_study.Get(ch.book, ch.chapter, v.number, ch.translation);
     int colorIdx = vd ? vd->highlightColor : 0; bool isBookmarked = vd ? vd->isBookmarked : false; bool hasNote = vd ? !vd->note.empty() : false;
     bool isSelected = s.selectedVerses.count(v.number);
     if (colorIdx > 0 || isSelected) { 
@@ -136,7 +133,7 @@ static void DrawVerseText(Font font, const Verse& v, float x, float& y, float ma
     Color nc = isBookmarked ? Color{255, 210, 60, 255} : numCol; DrawTextEx(font, numLabel.c_str(), {x, y + 2}, numFSize, 1, nc); 
     if (hasNote) { DrawCircleGradient((int)(x + numSz.x + 6), (int)(y + 8), 3, s.accent, {0,0,0,0}); }
     float tx = x + numSz.x + (hovered || isBookmarked ? 15.0f : 8.0f);
-    if (s.studyMode && !v.rawText.empty()) { auto lines = WrapStudyText(v.rawText, font, fSize, maxW - (tx - x)); for (const auto& ln : lines) { float rx = (&ln == &lines[0]) ? tx : x + 10.0f; DrawStudyLine(font, ln, rx, y, fSize, textCol, {200, 160, 40, 200}, s); y += fSize + lSpacing; } }
+    if (s.studyMode && !v.tags.empty()) { auto starts = WrapStudyText(v, font, fSize, maxW - (tx - x)); for (size_t li = 0; li < starts.size(); li++) { float rx = (li == 0) ? tx : x + 10.0f; DrawStudyLine(font, v, ch.bookIndex, starts[li], li + 1 < starts.size() ? starts[li + 1] : v.text.size(), rx, y, fSize, textCol, {200, 160, 40, 200}, s); y += fSize + lSpacing; } }
     else { auto lines = WrapText(v.text, font, fSize, maxW - (tx - x)); for (size_t li = 0; li < lines.size(); li++) { float rx = (li == 0) ? tx : x + 10.0f; if (!matches.empty()) { std::string lineLower = ToLower(lines[li]); for (const auto& m : matches) { if (m.matchPos < v.text.size()) { std::string matchStr = ToLower(v.text.substr(m.matchPos, std::min(m.matchLen, v.text.size() - m.matchPos))); size_t p = 0; while ((p = lineLower.find(matchStr, p)) != std::string::npos) { Vector2 pre = MeasureTextEx(font, lines[li].substr(0, p).c_str(), fSize, 1); Vector2 mid = MeasureTextEx(font, matchStr.c_str(), fSize, 1); DrawRectangleRec({rx + pre.x, y, mid.x, fSize + 2}, {hlCol.r, hlCol.g, hlCol.b, 120}); p += std::max((size_t)1, matchStr.size()); } } } } DrawTextEx(font, lines[li].c_str(), {rx, y}, fSize, 1, textCol); y += fSize + lSpacing; } }
     y += vGap;
 }
@@ -173,37 +170,37 @@ void DrawSidebar(AppState& s, Font f) {
     
     if (s.selectedVerses.size() > 1) {
         DrawTextEx(f, (std::to_string(s.selectedVerses.size()) + " verses selected").c_str(), {sx + 20, y}, 18, 1, s.text); y += 30;
-        if (s.buf.empty()) return;
-        std::string b = s.buf[0].book; int ch = s.buf[0].chapter;
+        if (s.view->buf.empty()) return;
+        std::string b = s.view->buf[0]->book; int ch = s.view->buf[0]->chapter;
         Rectangle ball = {sx + 20, y, 140, 30}; bool bah = CheckCollisionPointRec(GetMousePosition(), ball);
         DrawRectangleRec(ball, bah ? s.accent : s.bg); DrawRectangleLinesEx(ball, 1, s.vnum);
         DrawTextEx(f, "Bookmark All", {ball.x + 15, ball.y + 6}, 16, 1, bah ? RAYWHITE : s.text);
-        if (bah && IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) { for (int v : s.selectedVerses) g_study.SetBookmark(b, ch, v, s.trans, true, (v <= (int)s.buf[0].verses.size()) ? s.buf[0].verses[v-1].text : ""); } 
+        if (bah && IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) { for (int v : s.selectedVerses) g_study.SetBookmark(b, ch, v, s.trans, true, (v <= (int)s.view->buf[0]->verses.size()) ? std::string(s.view->buf[0]->verses[v-1].text) : ""); } 
         y += 40;
         DrawTextEx(f, "Highlight All:", {sx + 20, y}, 14, 1, s.vnum); y += 20;
         Color hcs[] = {{255,255,0,255}, {0,255,0,255}, {0,200,255,255}, {255,100,200,255}};
         for (int i = 0; i < 4; i++) {
-            Rectangle hr = {sx + 20 + (float)i * 35, y, 30, 30}; if (CheckCollisionPointRec(GetMousePosition(), hr) && IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) { for (int v : s.selectedVerses) g_study.SetHighlight(b, ch, v, s.trans, i + 1, (v <= (int)s.buf[0].verses.size()) ? s.buf[0].verses[v-1].text : ""); }
+            Rectangle hr = {sx + 20 + (float)i * 35, y, 30, 30}; if (CheckCollisionPointRec(GetMousePosition(), hr) && IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) { for (int v : s.selectedVerses) g_study.SetHighlight(b, ch, v, s.trans, i + 1, (v <= (int)s.view->buf[0]->verses.size()) ? std::string(s.view->buf[0]->verses[v-1].text) : ""); }
             DrawRectangleRec(hr, hcs[i]);
         }
         return;
     }
 
-    if (s.lastSelectedVerse == -1 || s.buf.empty()) { DrawTextEx(f, "Select a verse to see study info.", {sx + 20, y}, 16, 1, s.vnum); return; }
-    std::string b = s.buf[0].book; int ch = s.buf[0].chapter; int v = s.lastSelectedVerse;
+    if (s.lastSelectedVerse == -1 || s.view->buf.empty()) { DrawTextEx(f, "Select a verse to see study info.", {sx + 20, y}, 16, 1, s.vnum); return; }
+    std::string b = s.view->buf[0]->book; int ch = s.view->buf[0]->chapter; int v = s.lastSelectedVerse;
     std::string ref = b + " " + std::to_string(ch) + ":" + std::to_string(v); DrawTextEx(f, ref.c_str(), {sx + 20, y}, 20, 1, s.text); y += 30;
     auto* vd = g_study.Get(b, ch, v, s.trans);
     bool isBk = vd ? vd->isBookmarked : false;
     Rectangle bkr = {sx + 20, y, 120, 30}; bool bkh = CheckCollisionPointRec(GetMousePosition(), bkr);
     DrawRectangleRec(bkr, isBk ? s.accent : (bkh ? s.vnum : s.bg)); DrawRectangleLinesEx(bkr, 1, s.vnum);
     DrawTextEx(f, isBk ? "Bookmarked" : "Bookmark", {bkr.x + 10, bkr.y + 6}, 16, 1, (isBk || bkh) ? RAYWHITE : s.text);
-    if (bkh && IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) g_study.SetBookmark(b, ch, v, s.trans, !isBk, (v <= (int)s.buf[0].verses.size()) ? s.buf[0].verses[v-1].text : "");
+    if (bkh && IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) g_study.SetBookmark(b, ch, v, s.trans, !isBk, (v <= (int)s.view->buf[0]->verses.size()) ? std::string(s.view->buf[0]->verses[v-1].text) : "");
     y += 40; DrawTextEx(f, "Highlight:", {sx + 20, y}, 14, 1, s.vnum); y += 20;
     Color hcs[] = {{255,255,0,255}, {0,255,0,255}, {0,200,255,255}, {255,100,200,255}};
     for (int i = 0; i < 4; i++) {
         Rectangle hr = {sx + 20 + (float)i * 35, y, 30, 30}; bool hh = CheckCollisionPointRec(GetMousePosition(), hr);
         DrawRectangleRec(hr, hcs[i]); if (vd && vd->highlightColor == i + 1) DrawRectangleLinesEx(hr, 2, BLACK);
-        if (hh && IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) g_study.SetHighlight(b, ch, v, s.trans, i + 1, (v <= (int)s.buf[0].verses.size()) ? s.buf[0].verses[v-1].text : "");
+        if (hh && IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) g_study.SetHighlight(b, ch, v, s.trans, i + 1, (v <= (int)s.view->buf[0]->verses.size()) ? std::string(s.view->buf[0]->verses[v-1].text) : "");
     }
     Rectangle clr = {sx + 20 + 4 * 35, y, 30, 30}; if (CheckCollisionPointRec(GetMousePosition(), clr) && IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) g_study.SetHighlight(b, ch, v, s.trans, 0);
     DrawRectangleLinesEx(clr, 1, s.vnum); DrawLineEx({clr.x, clr.y}, {clr.x + 30, clr.y + 30}, 1, s.err);
@@ -325,14 +322,34 @@ void DrawFavoritesPanel(AppState& s, Font f) {
 }
 
 void DrawCachePanel(AppState& s, Font f) {
-    float pw = 420, ph = 480, px = ((float)GetScreenWidth() - pw) / 2.f, py = 100;
+    float pw = 480, ph = 810, px = ((float)GetScreenWidth() - pw) / 2.f, py = 10;
+    DownloadProgress dl = g_downloader.Progress(); static bool dlWasActive = false; if (dl.active || dlWasActive || s.cacheStats.evicting) s.cacheStats = g_cache.Stats(); dlWasActive = dl.active; // Live counts while downloading or evicting
+    auto button = [&](Rectangle r, const char* lbl, Color edge) { bool h = CheckCollisionPointRec(GetMousePosition(), r); DrawRectangleRec(r, h ? s.accent : s.bg); DrawRectangleLinesEx(r, 1, edge); DrawTextEx(f, lbl, {r.x + 8, r.y + 5}, 14, 1, h ? RAYWHITE : s.text); return h && IsMouseButtonPressed(MOUSE_LEFT_BUTTON); };
     DrawRectangle(0, 0, GetScreenWidth(), GetScreenHeight(), {0, 0, 0, 180}); DrawRectangle(px, py, pw, ph, s.hdr); DrawRectangleLinesEx({px, py, pw, ph}, 2, s.vnum); DrawTextEx(f, "Cache Statistics", {px + 20, py + 20}, 24, 1, s.accent); float y = py + 65;
     auto row = [&](const char* k, const std::string& v) { DrawTextEx(f, k, {px + 25, y}, 17, 1, s.vnum); DrawTextEx(f, v.c_str(), {px + 220, y}, 17, 1, s.text); y += 30; };
-    row("Chapters cached:", std::to_string(s.cacheStats.totalChapters)); row("Total verses:", std::to_string(s.cacheStats.totalVerses)); row("Disk usage:", FmtBytes(s.cacheStats.totalSize));
-    y += 15; DrawTextEx(f, "By translation:", {px + 25, y}, 18, 1, s.accent); y += 32;
-    for (const auto& t : TRANSLATIONS) { int cnt = 0; auto it = s.cacheStats.byTranslation.find(t.code); if (it != s.cacheStats.byTranslation.end()) cnt = it->second; row(("  " + t.code + ":").c_str(), std::to_string(cnt) + " chapters"); }
-    Rectangle clrBtn = { px + 25, py + ph - 50, 140, 34 }; bool clrHov = CheckCollisionPointRec(GetMousePosition(), clrBtn); DrawRectangleRec(clrBtn, clrHov ? s.err : s.hdr); DrawRectangleLinesEx(clrBtn, 1, s.err); DrawTextEx(f, "CLEAR CACHE", { clrBtn.x + 15, clrBtn.y + 8 }, 16, 1, clrHov ? RAYWHITE : s.err);
-    if (clrHov && IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) { g_cache.ClearCache(); s.cacheStats = g_cache.Stats(); s.SetStatus("Cache cleared.", 2.0f); }
+    row("Chapters cached:", std::to_string(s.cacheStats.totalChapters)); row("Total verses:", std::to_string(s.cacheStats.totalVerses)); row("Disk usage:", FmtBytes(s.cacheStats.totalSize) + (s.cacheStats.quota ? " / " + FmtBytes(s.cacheStats.quota) : "") + (s.cacheStats.evicted ? "  (" + std::to_string(s.cacheStats.evicted) + " evicted)" : ""));
+    int ratio = s.cacheStats.totalSize > 0 ? (int)(10.0 * s.cacheStats.logicalSize / s.cacheStats.totalSize) : 0; row("Uncompressed:", FmtBytes(s.cacheStats.logicalSize) + (ratio ? "  (" + std::to_string(ratio / 10) + "." + std::to_string(ratio % 10) + "x)" : ""));
+    ChapterStoreStats ms = g_chapters.Stats(); row("Memory cache:", FmtBytes((long)ms.bytes) + " / " + FmtBytes((long)ms.budget)); row("Hits / misses:", std::to_string(ms.hits) + " / " + std::to_string(ms.misses));
+    row("Lock waits (r / w):", std::to_string(s.cacheStats.readWaits) + " / " + std::to_string(s.cacheStats.writeWaits) + " of " + std::to_string(s.cacheStats.lockCount));
+    HttpStats hs = g_http.Stats(); row("Connections opened:", std::to_string(hs.connects) + " for " + std::to_string(hs.requests) + " requests" + (hs.retries ? ", " + std::to_string(hs.retries) + " retried" : ""));
+    row("Time to first verse:", s.firstVerseMs >= 0 ? std::to_string(s.firstVerseMs) + " ms" : "-");
+    { std::string w; const char* names[] = {"nav ", "grow ", "pre ", "search "}; // Average wait from submit to start, per class
+      for (int c = 0; c < (int)TaskClass::Count; c++) w += (c ? ", " : "") + std::string(names[c]) + std::to_string((int)(s.scheduler.Stats((TaskClass)c).waitAvgMs + 0.5));
+      row("Queue wait (ms):", w); }
+    PrefetchStats pf = g_prefetch.Stats(); row("Prefetch:", std::to_string(pf.hits) + " hits, " + std::to_string(pf.wasted) + " wasted, " + FmtBytes((long)pf.heldBytes) + " held");
+    LexiconStats ls = g_lexicon.Stats(); row("Lexicon:", std::to_string(ls.entries) + " words" + (ls.queued ? ", " + std::to_string(ls.queued) + " queued" : ""));
+    y += 15; DrawTextEx(f, "By translation:", {px + 25, y}, 18, 1, s.accent); y += 32; int total = 0; for (const auto& b : BIBLE_BOOKS) total += b.chapters;
+    for (const auto& t : TRANSLATIONS) { int cnt = 0; auto it = s.cacheStats.byTranslation.find(t.code); if (it != s.cacheStats.byTranslation.end()) cnt = it->second;
+        if (cnt < total && !dl.active && button({px + pw - 100, y - 4, 75, 24}, "Download", s.vnum) && g_downloader.Start(t.code, g_settings.downloadConcurrency, g_settings.downloadRate)) s.SetStatus("Downloading " + t.code + " for offline use...", 2.0f);
+        if (cnt > 0 && !(dl.active && dl.translation == t.code) && button({px + pw - 160, y - 4, 52, 24}, "Evict", s.err)) { g_cache.Evict(t.code); s.cacheStats = g_cache.Stats(); s.SetStatus("Evicting " + t.code + " from the cache...", 2.0f); }
+        row(("  " + t.code + ":").c_str(), std::to_string(cnt) + " / " + std::to_string(total)); }
+    if (dl.total > 0) { float prog = (float)(dl.done + dl.failed) / dl.total; std::string lbl = dl.translation + (dl.active ? (dl.cancelled ? ": cancelling" : ": downloading") : dl.cancelled ? ": cancelled" : ": finished") + "  " + std::to_string(dl.done) + " / " + std::to_string(dl.total) + (dl.failed ? "  (" + std::to_string(dl.failed) + " failed)" : "");
+        y += 8; DrawTextEx(f, lbl.c_str(), {px + 25, y}, 15, 1, dl.failed ? s.err : s.vnum); y += 22; DrawRectangle(px + 25, y, pw - 50, 6, s.bg); DrawRectangle(px + 25, y, (pw - 50) * prog, 6, s.accent); y += 14; }
+    if (s.curBookIdx >= 0 && s.curBookIdx < (int)BIBLE_BOOKS.size()) { std::string lbl = "Evict " + BIBLE_BOOKS[s.curBookIdx].name + " (" + s.trans + ")"; y += 8;
+        if (button({px + 25, y, MeasureTextEx(f, lbl.c_str(), 14, 1).x + 16, 24}, lbl.c_str(), s.err)) { g_cache.Evict(s.trans, s.curBookIdx); s.cacheStats = g_cache.Stats(); s.SetStatus("Evicting " + BIBLE_BOOKS[s.curBookIdx].name + " from the cache...", 2.0f); } }
+    if (dl.active && !dl.cancelled) { Rectangle xb = {px + 175, py + ph - 50, 100, 34}; bool xh = CheckCollisionPointRec(GetMousePosition(), xb); DrawRectangleRec(xb, xh ? s.accent : s.bg); DrawRectangleLinesEx(xb, 1, s.vnum); DrawTextEx(f, "Cancel", {xb.x + 24, xb.y + 8}, 18, 1, xh ? RAYWHITE : s.text); if (xh && IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) g_downloader.Cancel(); }
+    Rectangle clrBtn = { px + 25, py + ph - 50, 140, 34 }; bool clrHov = !dl.active && CheckCollisionPointRec(GetMousePosition(), clrBtn); DrawRectangleRec(clrBtn, clrHov ? s.err : s.hdr); DrawRectangleLinesEx(clrBtn, 1, s.err); DrawTextEx(f, "CLEAR CACHE", { clrBtn.x + 15, clrBtn.y + 8 }, 16, 1, clrHov ? RAYWHITE : s.err);
+    if (clrHov && IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) { g_cache.ClearCache(); g_chapters.Clear(); s.cacheStats = g_cache.Stats(); s.SetStatus("Cache cleared.", 2.0f); }
     Rectangle cb = {px + pw - 120, py + ph - 50, 100, 34}; bool ch = CheckCollisionPointRec(GetMousePosition(), cb); DrawRectangleRec(cb, ch ? s.accent : s.bg); DrawRectangleLinesEx(cb, 1, s.vnum); DrawTextEx(f, "Close", {cb.x + 28, cb.y + 8}, 18, 1, ch ? RAYWHITE : s.text); if (ch && IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) s.showCache = false;
 }
 
@@ -361,7 +378,7 @@ void DrawSearchPanel(AppState& s, Font f) {
     Rectangle gBtn = {px + 15, py + 90, pw - 30, 30}; bool gHov = CheckCollisionPointRec(GetMousePosition(), gBtn); DrawRectangleRec(gBtn, gHov ? s.accent : s.hdr); DrawRectangleLinesEx(gBtn, 1, s.vnum); DrawTextEx(f, "Search Entire Bible...", {gBtn.x + 10, gBtn.y + 7}, 15, 1, gHov ? RAYWHITE : s.vnum);
     if (gHov && IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) { closeAllPanels(s); s.showGlobalSearch = true; strncpy(s.gSearchBuf, s.searchBuf, 255); }
     Rectangle cbr = {px + 15, py + 130, 18, 18}; DrawRectangleRec(cbr, s.searchCS ? s.accent : s.bg); DrawRectangleLinesEx(cbr, 1, s.vnum); if (s.searchCS) DrawTextEx(f, "v", {cbr.x + 3, cbr.y}, 14, 1, RAYWHITE); DrawTextEx(f, "Case sensitive", {cbr.x + 28, cbr.y}, 16, 1, s.text);
-    if (CheckCollisionPointRec(GetMousePosition(), cbr) && IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) { s.searchCS = !s.searchCS; if (strlen(s.searchBuf) > 0) { s.searchResults = SearchVerses(s.buf, s.searchBuf, s.searchCS); } }
+    if (CheckCollisionPointRec(GetMousePosition(), cbr) && IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) { s.searchCS = !s.searchCS; if (strlen(s.searchBuf) > 0) { s.searchResults = SearchVerses(s.view->buf, s.searchBuf, s.searchCS); } }
     DrawTextEx(f, (std::to_string(s.searchResults.size()) + " match(es)").c_str(), {px + 15, py + 155}, 15, 1, s.vnum); float ry = py + 180;
     for (int i = 0; i < (int)s.searchResults.size() && i < 7; i++) { const auto& m = s.searchResults[i]; std::string lbl = "v." + std::to_string(m.verseNumber) + ": " + (m.text.size() > 40 ? m.text.substr(0, 37) + "..." : m.text); Rectangle r = {px + 15, ry, pw - 30, 34}; bool hov = CheckCollisionPointRec(GetMousePosition(), r); if (hov) DrawRectangleRec(r, {s.accent.r, s.accent.g, s.accent.b, 60}); if (i == s.searchSel) DrawRectangleLinesEx(r, 1, s.vnum); DrawTextEx(f, lbl.c_str(), {r.x + 8, r.y + 8}, 15, 1, s.text);
         if (hov && IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) { s.searchSel = i; s.curBookIdx = m.bookIndex; s.curChNum = m.chapter; s.scrollToVerse = m.verseNumber; s.InitBuffer(); if (s.bookMode) s.needsPageRebuild = true; s.showSearch = false; } ry += 38; }
@@ -393,7 +410,7 @@ void DrawNoteEditor(AppState& s, Font f) {
     int key = GetCharPressed(); while (key > 0) { size_t len = strlen(s.noteBuf); if (key >= 32 && key <= 126 && len < 511) { s.noteBuf[len] = (char)key; s.noteBuf[len+1] = 0; } key = GetCharPressed(); }
     if (IsKeyPressed(KEY_BACKSPACE)) { size_t len = strlen(s.noteBuf); if (len > 0) s.noteBuf[len-1] = 0; }
     Rectangle saveBtn = {px + pw - 220, py + ph - 50, 100, 34}, cancelBtn = {px + pw - 110, py + ph - 50, 100, 34}; bool sHov = CheckCollisionPointRec(GetMousePosition(), saveBtn), cHov = CheckCollisionPointRec(GetMousePosition(), cancelBtn); DrawRectangleRec(saveBtn, sHov ? s.ok : s.bg); DrawRectangleLinesEx(saveBtn, 1, s.vnum); DrawTextEx(f, "SAVE", {saveBtn.x + 25, saveBtn.y + 8}, 18, 1, sHov ? RAYWHITE : s.text);
-    if (sHov && IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) { if (s.lastSelectedVerse != -1 && !s.buf.empty()) g_study.SetNote(s.buf[0].book, s.buf[0].chapter, s.lastSelectedVerse, s.trans, s.noteBuf); s.showNoteEditor = false; }
+    if (sHov && IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) { if (s.lastSelectedVerse != -1 && !s.view->buf.empty()) g_study.SetNote(s.view->buf[0]->book, s.view->buf[0]->chapter, s.lastSelectedVerse, s.trans, s.noteBuf); s.showNoteEditor = false; }
     DrawRectangleRec(cancelBtn, cHov ? s.accent : s.bg); DrawRectangleLinesEx(cancelBtn, 1, s.vnum); DrawTextEx(f, "CANCEL", {cancelBtn.x + 15, cancelBtn.y + 8}, 18, 1, cHov ? RAYWHITE : s.text); if (cHov && IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) s.showNoteEditor = false;
 }
 
@@ -420,17 +437,17 @@ void DrawHeader(AppState& s, Font f) {
 }
 
 void DrawScrollMode(AppState& s, Font f) {
-    std::lock_guard<std::mutex> lock(s.bufferMutex); const float TOP = 60, BOT = 38; float sw = s.showSidebar ? s.sidebarWidth : 0; float mw = (float)GetScreenWidth() - sw; float h = (float)GetScreenHeight() - TOP - BOT; bool overlayOpen = IsAnyOverlayOpen(s);
+    const float TOP = 60, BOT = 38; float sw = s.showSidebar ? s.sidebarWidth : 0; float mw = (float)GetScreenWidth() - sw; float h = (float)GetScreenHeight() - TOP - BOT; bool overlayOpen = IsAnyOverlayOpen(s);
     if (!overlayOpen && !s.isLoading) { float wheel = GetMouseWheelMove(); if (CheckCollisionPointRec(GetMousePosition(), {0, TOP, mw, h})) s.targetScrollY += wheel * 100.0f; }
     const float PAD = 40, FS = s.fontSize, LS = s.lineSpacing, VG = 14; BeginScissorMode(0, (int)TOP, (int)mw, (int)h); float yFinal = TOP + 18 + s.scrollY; s.scrollChapterIdx = 0;
-    if (s.parallelMode) { float colW = (mw - PAD * 3) / 2.0f; yFinal = TOP + 18 + s.scrollY; float y1 = yFinal, y2 = yFinal; int chapterCount = (int)s.buf.size();
-        for (int ci = 0; ci < chapterCount; ci++) { const Chapter& ch1 = s.buf[ci]; float chapterStartY = y1;
+    if (s.parallelMode) { float colW = (mw - PAD * 3) / 2.0f; yFinal = TOP + 18 + s.scrollY; float y1 = yFinal, y2 = yFinal; int chapterCount = (int)s.view->buf.size();
+        for (int ci = 0; ci < chapterCount; ci++) { const Chapter& ch1 = *s.view->buf[ci]; float chapterStartY = y1;
             if (ch1.isLoaded) { if (y1 <= TOP + 50 && y1 + 100 > TOP) s.scrollChapterIdx = ci; DrawTextEx(f, ch1.book.c_str(), {PAD, y1}, 24, 1, s.accent); DrawTextEx(f, ch1.translation.c_str(), {PAD + colW - 40, y1 + 6}, 12, 1, s.vnum); y1 += 34; DrawLineEx({PAD, y1}, {PAD + colW, y1}, 2, s.vnum); y1 += 14;
-                for (const auto& v : ch1.verses) { bool isSel = s.selectedVerses.count(v.number); if (isSel) DrawRectangleRec({PAD - 5, y1 - 2, colW + 10, FS + LS + 4}, {s.accent.r, s.accent.g, s.accent.b, 40}); if (s.scrollToVerse == v.number && ci == 0) { s.targetScrollY = -(y1 - s.scrollY - TOP - 20); s.scrollToVerse = -1; } Rectangle vRec = {PAD, y1, colW, FS + 4}; bool vHov = CheckCollisionPointRec(GetMousePosition(), vRec); std::vector<SearchMatch> vm; for (const auto& m : s.searchResults) if (m.bookIndex == ch1.bookIndex && m.chapter == ch1.chapter && m.verseNumber == v.number) vm.push_back(m); DrawVerseText(f, v, PAD, y1, colW, FS, LS, VG, s.text, s.vnum, vHov, vm, {220, 180, 60, 120}, s, ch1.book, ch1.chapter, ch1.translation); if (vHov && IsMouseButtonPressed(MOUSE_LEFT_BUTTON) && !overlayOpen) { s.lastSelectedVerse = v.number; s.scrollChapterIdx = ci; if (IsKeyDown(KEY_LEFT_SHIFT) || IsKeyDown(KEY_RIGHT_SHIFT)) s.ToggleVerseSelection(v.number); else { s.ClearSelection(); s.ToggleVerseSelection(v.number); } } if (vHov && IsMouseButtonPressed(MOUSE_RIGHT_BUTTON) && !overlayOpen) { std::string q = "\"" + v.text + "\"\n\xE2\x80\x94 " + ch1.book + ":" + std::to_string(v.number) + " (" + ch1.translation + ")"; CopyToClipboard(q); SaveVerseImage(v, ch1.book, ch1.translation, f); s.SetStatus("Verse copied!"); } } } else { DrawTextEx(f, "Loading...", {PAD, y1}, 18, 1, s.vnum); y1 += 50; }
-            float leftEndY = y1; y2 = chapterStartY; if (ci < (int)s.buf2.size()) { const Chapter& ch2 = s.buf2[ci]; if (ch2.isLoaded) { DrawTextEx(f, ch2.book.c_str(), {PAD * 2 + colW, y2}, 24, 1, s.accent); DrawTextEx(f, ch2.translation.c_str(), {PAD * 2 + colW * 2 - 40, y2 + 6}, 12, 1, s.vnum); y2 += 34; DrawLineEx({PAD * 2 + colW, y2}, {PAD * 2 + colW * 2, y2}, 2, s.vnum); y2 += 14; for (const auto& v : ch2.verses) { DrawVerseText(f, v, PAD * 2 + colW, y2, colW, FS, LS, VG, s.text, s.vnum, false, {}, {220, 180, 60, 120}, s, ch2.book, ch2.chapter, ch2.translation); } } else { DrawTextEx(f, "Loading...", {PAD * 2 + colW, y2}, 18, 1, s.vnum); y2 += 50; } } else { DrawTextEx(f, "Connecting...", {PAD * 2 + colW, y2}, 18, 1, s.vnum); y2 += 50; } y1 = y2 = std::max(leftEndY, y2) + 40; } yFinal = y1;
+                for (const auto& v : ch1.verses) { bool isSel = s.selectedVerses.count(v.number); if (isSel) DrawRectangleRec({PAD - 5, y1 - 2, colW + 10, FS + LS + 4}, {s.accent.r, s.accent.g, s.accent.b, 40}); if (s.scrollToVerse == v.number && ci == 0) { s.targetScrollY = -(y1 - s.scrollY - TOP - 20); s.scrollToVerse = -1; } Rectangle vRec = {PAD, y1, colW, FS + 4}; bool vHov = CheckCollisionPointRec(GetMousePosition(), vRec); std::vector<SearchMatch> vm; for (const auto& m : s.searchResults) if (m.bookIndex == ch1.bookIndex && m.chapter == ch1.chapter && m.verseNumber == v.number) vm.push_back(m); DrawVerseText(f, v, PAD, y1, colW, FS, LS, VG, s.text, s.vnum, vHov, vm, {220, 180, 60, 120}, s, ch1); if (vHov && IsMouseButtonPressed(MOUSE_LEFT_BUTTON) && !overlayOpen) { s.lastSelectedVerse = v.number; s.scrollChapterIdx = ci; if (IsKeyDown(KEY_LEFT_SHIFT) || IsKeyDown(KEY_RIGHT_SHIFT)) s.ToggleVerseSelection(v.number); else { s.ClearSelection(); s.ToggleVerseSelection(v.number); } } if (vHov && IsMouseButtonPressed(MOUSE_RIGHT_BUTTON) && !overlayOpen) { std::string q = "\"" + std::string(v.text) + "\"\n\xE2\x80\x94 " + ch1.book + ":" + std::to_string(v.number) + " (" + ch1.translation + ")"; CopyToClipboard(q); SaveVerseImage(v, ch1.book, ch1.translation, f); s.SetStatus("Verse copied!"); } } } else { DrawTextEx(f, "Loading...", {PAD, y1}, 18, 1, s.vnum); y1 += 50; }
+            float leftEndY = y1; y2 = chapterStartY; if (ci < (int)s.view->buf2.size()) { const Chapter& ch2 = *s.view->buf2[ci]; if (ch2.isLoaded) { DrawTextEx(f, ch2.book.c_str(), {PAD * 2 + colW, y2}, 24, 1, s.accent); DrawTextEx(f, ch2.translation.c_str(), {PAD * 2 + colW * 2 - 40, y2 + 6}, 12, 1, s.vnum); y2 += 34; DrawLineEx({PAD * 2 + colW, y2}, {PAD * 2 + colW * 2, y2}, 2, s.vnum); y2 += 14; for (const auto& v : ch2.verses) { DrawVerseText(f, v, PAD * 2 + colW, y2, colW, FS, LS, VG, s.text, s.vnum, false, {}, {220, 180, 60, 120}, s, ch2); } } else { DrawTextEx(f, "Loading...", {PAD * 2 + colW, y2}, 18, 1, s.vnum); y2 += 50; } } else { DrawTextEx(f, "Connecting...", {PAD * 2 + colW, y2}, 18, 1, s.vnum); y2 += 50; } y1 = y2 = std::max(leftEndY, y2) + 40; } yFinal = y1;
     } else { const float TW = mw - PAD * 2; float y = TOP + 18 + s.scrollY;
-        for (int ci = 0; ci < (int)s.buf.size(); ci++) { const Chapter& ch = s.buf[ci]; if (!ch.isLoaded) continue; if (y <= TOP + 50 && y + 100 > TOP) s.scrollChapterIdx = ci; DrawTextEx(f, ch.book.c_str(), {PAD, y}, 28, 1, s.accent); y += 38; DrawLineEx({PAD, y}, {mw - PAD, y}, 2, s.vnum); DrawLineEx({PAD, y + 3}, {mw - PAD, y + 3}, 1, {s.vnum.r, s.vnum.g, s.vnum.b, 80}); y += 18;
-            for (const auto& v : ch.verses) { bool isSel = s.selectedVerses.count(v.number); if (isSel) DrawRectangleRec({PAD - 10, y - 2, TW + 20, s.fontSize + s.lineSpacing + 4}, {s.accent.r, s.accent.g, s.accent.b, 40}); if (s.scrollToVerse == v.number && ci == 0) { s.targetScrollY = -(y - s.scrollY - TOP - 20); s.scrollToVerse = -1; } Rectangle numR = {PAD, y, TW, FS + 4}; bool numHov = CheckCollisionPointRec(GetMousePosition(), numR); std::vector<SearchMatch> vm; for (const auto& m : s.searchResults) if (m.bookIndex == ch.bookIndex && m.chapter == ch.chapter && m.verseNumber == v.number) vm.push_back(m); DrawVerseText(f, v, PAD, y, TW, FS, LS, VG, s.text, s.vnum, numHov, vm, {220, 180, 60, 120}, s, ch.book, ch.chapter, ch.translation); if (numHov && IsMouseButtonPressed(MOUSE_LEFT_BUTTON) && !overlayOpen) { s.lastSelectedVerse = v.number; s.scrollChapterIdx = ci; if (IsKeyDown(KEY_LEFT_SHIFT) || IsKeyDown(KEY_RIGHT_SHIFT)) s.ToggleVerseSelection(v.number); else { s.ClearSelection(); s.ToggleVerseSelection(v.number); } } if (numHov && IsMouseButtonPressed(MOUSE_RIGHT_BUTTON) && !overlayOpen) { std::string q = "\"" + v.text + "\"\n\xE2\x80\x94 " + ch.book + ":" + std::to_string(v.number) + " (" + ch.translation + ")"; CopyToClipboard(q); SaveVerseImage(v, ch.book, ch.translation, f); s.SetStatus("Verse copied!"); } } y += 40; } yFinal = y; }
+        for (int ci = 0; ci < (int)s.view->buf.size(); ci++) { const Chapter& ch = *s.view->buf[ci]; if (!ch.isLoaded) continue; if (y <= TOP + 50 && y + 100 > TOP) s.scrollChapterIdx = ci; DrawTextEx(f, ch.book.c_str(), {PAD, y}, 28, 1, s.accent); y += 38; DrawLineEx({PAD, y}, {mw - PAD, y}, 2, s.vnum); DrawLineEx({PAD, y + 3}, {mw - PAD, y + 3}, 1, {s.vnum.r, s.vnum.g, s.vnum.b, 80}); y += 18;
+            for (const auto& v : ch.verses) { bool isSel = s.selectedVerses.count(v.number); if (isSel) DrawRectangleRec({PAD - 10, y - 2, TW + 20, s.fontSize + s.lineSpacing + 4}, {s.accent.r, s.accent.g, s.accent.b, 40}); if (s.scrollToVerse == v.number && ci == 0) { s.targetScrollY = -(y - s.scrollY - TOP - 20); s.scrollToVerse = -1; } Rectangle numR = {PAD, y, TW, FS + 4}; bool numHov = CheckCollisionPointRec(GetMousePosition(), numR); std::vector<SearchMatch> vm; for (const auto& m : s.searchResults) if (m.bookIndex == ch.bookIndex && m.chapter == ch.chapter && m.verseNumber == v.number) vm.push_back(m); DrawVerseText(f, v, PAD, y, TW, FS, LS, VG, s.text, s.vnum, numHov, vm, {220, 180, 60, 120}, s, ch); if (numHov && IsMouseButtonPressed(MOUSE_LEFT_BUTTON) && !overlayOpen) { s.lastSelectedVerse = v.number; s.scrollChapterIdx = ci; if (IsKeyDown(KEY_LEFT_SHIFT) || IsKeyDown(KEY_RIGHT_SHIFT)) s.ToggleVerseSelection(v.number); else { s.ClearSelection(); s.ToggleVerseSelection(v.number); } } if (numHov && IsMouseButtonPressed(MOUSE_RIGHT_BUTTON) && !overlayOpen) { std::string q = "\"" + std::string(v.text) + "\"\n\xE2\x80\x94 " + ch.book + ":" + std::to_string(v.number) + " (" + ch.translation + ")"; CopyToClipboard(q); SaveVerseImage(v, ch.book, ch.translation, f); s.SetStatus("Verse copied!"); } } y += 40; } yFinal = y; }
     EndScissorMode(); float contentH = yFinal - TOP - s.scrollY; if (contentH > h) { float barH = (h / contentH) * h; if (barH < 30) barH = 30; float barY = TOP + (-s.scrollY / (contentH - h)) * (h - barH); Rectangle scrollRect = { mw - 10, barY, 6, barH }; DrawRectangleRec(scrollRect, { s.vnum.r, s.vnum.g, s.vnum.b, 150 }); if (CheckCollisionPointRec(GetMousePosition(), { mw - 15, TOP, 15, h }) && IsMouseButtonDown(MOUSE_LEFT_BUTTON) && !overlayOpen) { float delta = GetMouseDelta().y; s.targetScrollY -= delta * (contentH / h); } }
     float ay = TOP + h / 2.0f - 25; auto drawFloatNav = [&](Rectangle r, const char* lbl, bool en) { bool hov = !overlayOpen && en && CheckCollisionPointRec(GetMousePosition(), r); if (en) { DrawRectangleRec(r, hov ? s.accent : (Color){ s.hdr.r, s.hdr.g, s.hdr.b, 180 }); DrawRectangleLinesEx(r, 2, s.vnum); Vector2 sz = MeasureTextEx(f, lbl, 24, 1); DrawTextEx(f, lbl, { r.x + (r.width - sz.x) / 2, r.y + (r.height - sz.y) / 2 }, 24, 1, hov ? RAYWHITE : s.text); } return hov && IsMouseButtonPressed(MOUSE_LEFT_BUTTON); };
     if (drawFloatNav({ 5, ay, 40, 50 }, "<", !(s.curBookIdx == 0 && s.curChNum == 1))) { PrevChapter(s.curBookIdx, s.curChNum); s.targetScrollY = 0; s.scrollY = 0; s.InitBuffer(); if (s.bookMode) s.needsPageRebuild = true; }
@@ -439,17 +456,22 @@ void DrawScrollMode(AppState& s, Font f) {
 }
 
 void DrawBookMode(AppState& s, Font f) {
-    std::lock_guard<std::mutex> lock(s.bufferMutex); const float TOP = 60, BOT = 38; float sw = s.showSidebar ? s.sidebarWidth : 0; float mw = (float)GetScreenWidth() - sw; float ch = (float)GetScreenHeight() - TOP - BOT; float pageW = std::min(700.f, mw - 100), pageH = std::min(500.f, ch - 40), pageX = (mw - pageW) / 2.f, pageY = TOP + (ch - pageH) / 2.f;
+    const float TOP = 60, BOT = 38; float sw = s.showSidebar ? s.sidebarWidth : 0; float mw = (float)GetScreenWidth() - sw; float ch = (float)GetScreenHeight() - TOP - BOT; float pageW = std::min(700.f, mw - 100), pageH = std::min(500.f, ch - 40), pageX = (mw - pageW) / 2.f, pageY = TOP + (ch - pageH) / 2.f;
     if (s.pages.empty()) { const char* msg = s.isLoading ? "Loading..." : "No content loaded yet."; Vector2 ms = MeasureTextEx(f, msg, 18, 1); DrawTextEx(f, msg, {(mw - ms.x) / 2.f, TOP + ch / 2.f - 9}, 18, 1, s.vnum); return; }
     DrawRectangle((int)(pageX + 6), (int)(pageY + 6), (int)pageW, (int)pageH, s.pageShadow); DrawRectangle((int)pageX, (int)pageY, (int)pageW, (int)pageH, s.pageBg); DrawRectangleLinesEx({pageX, pageY, pageW, pageH}, 2, s.accent);
     const Page& pg = s.pages[s.pageIdx]; float ty = pageY + 22;
-    if (pg.isChapterStart && pg.chapterBufIndex < (int)s.buf.size()) { const std::string& hdr = s.buf[pg.chapterBufIndex].book; DrawTextEx(f, hdr.c_str(), {pageX + 28, ty}, 21, 1, s.accent); if (s.parallelMode) { std::string t1 = s.trans, t2 = s.trans2; std::transform(t1.begin(), t1.end(), t1.begin(), ::toupper); std::transform(t2.begin(), t2.end(), t2.begin(), ::toupper); DrawTextEx(f, t1.c_str(), {pageX + 28, ty + 24}, 12, 1, s.vnum); DrawTextEx(f, t2.c_str(), {pageX + pageW/2 + 12, ty + 24}, 12, 1, s.vnum); } DrawLineEx({pageX + 28, ty + 38}, {pageX + pageW - 28, ty + 38}, 1, {s.accent.r, s.accent.g, s.accent.b, 80}); ty += 52; }
-    if (!s.parallelMode) { for (size_t i = 0; i < pg.lines.size(); i++) { int vNum = pg.lineVerses[i]; int ci = pg.chapterBufIndex; if (ci >= 0 && ci < (int)s.buf.size()) { const auto& ch = s.buf[ci]; const Verse* vPtr = nullptr; for (const auto& v : ch.verses) if (v.number == vNum) { vPtr = &v; break; }
-                if (s.studyMode && vPtr && !vPtr->rawText.empty()) { DrawStudyLine(f, pg.lines[i], pageX + 28, ty, s.fontSize, s.text, {200, 160, 40, 200}, s); } else { for (const auto& m : s.searchResults) { if (m.bookIndex == ch.bookIndex && m.chapter == ch.chapter && m.verseNumber == vNum) { std::string matchStr = ToLower(s.searchBuf); std::string lineLower = ToLower(pg.lines[i]); size_t p = 0; while ((p = lineLower.find(matchStr, p)) != std::string::npos) { Vector2 pre = MeasureTextEx(f, pg.lines[i].substr(0, p).c_str(), s.fontSize, 1); Vector2 mid = MeasureTextEx(f, s.searchBuf, s.fontSize, 1); DrawRectangleRec({pageX + 28 + pre.x, ty, mid.x, s.fontSize + 2}, {220, 180, 60, 120}); p += matchStr.size(); } } } DrawTextEx(f, pg.lines[i].c_str(), {pageX + 28, ty}, s.fontSize, 1, s.text); } } ty += s.fontSize + s.lineSpacing; } }
-    else { float startTy = ty; for (size_t i = 0; i < pg.lines.size(); i++) { if (s.studyMode) DrawStudyLine(f, pg.lines[i], pageX + 28, ty, s.fontSize, s.text, {200, 160, 40, 200}, s); else DrawTextEx(f, pg.lines[i].c_str(), {pageX + 28, ty}, s.fontSize, 1, s.text); ty += s.fontSize + s.lineSpacing; } ty = startTy; for (size_t i = 0; i < pg.lines2.size(); i++) { DrawTextEx(f, pg.lines2[i].c_str(), {pageX + pageW/2 + 12, ty}, s.fontSize, 1, s.text); ty += s.fontSize + s.lineSpacing; } }
+    // Page lines are wrapped clean text; in study mode each one is located back in its verse so the Strong's tags inside it can be drawn
+    int studyVerse = -1; size_t studyOff = 0;
+    auto drawStudyPageLine = [&](const Chapter& ch, const std::string& ln, int vNum, float x, float y) -> bool { const Verse* vp = nullptr; for (const auto& v : ch.verses) if (v.number == vNum) { vp = &v; break; } if (!vp || vp->tags.empty()) return false;
+        size_t skip = ln.compare(0, 4, "    ") == 0 ? 4 : ln.find(' ') + 1; if (vNum != studyVerse) { studyVerse = vNum; studyOff = 0; } size_t b = vp->text.find(ln.c_str() + skip, studyOff); if (b == std::string::npos) return false; size_t len = ln.size() - skip; studyOff = b + len;
+        std::string pre = ln.substr(0, skip); DrawTextEx(f, pre.c_str(), {x, y}, s.fontSize, 1, s.text); DrawStudyLine(f, *vp, ch.bookIndex, b, std::min(b + len + 1, vp->text.size()), x + MeasureTextEx(f, pre.c_str(), s.fontSize, 1).x, y, s.fontSize, s.text, {200, 160, 40, 200}, s); return true; };
+    if (pg.isChapterStart && pg.chapterBufIndex < (int)s.view->buf.size()) { const std::string& hdr = s.view->buf[pg.chapterBufIndex]->book; DrawTextEx(f, hdr.c_str(), {pageX + 28, ty}, 21, 1, s.accent); if (s.parallelMode) { std::string t1 = s.trans, t2 = s.trans2; std::transform(t1.begin(), t1.end(), t1.begin(), ::toupper); std::transform(t2.begin(), t2.end(), t2.begin(), ::toupper); DrawTextEx(f, t1.c_str(), {pageX + 28, ty + 24}, 12, 1, s.vnum); DrawTextEx(f, t2.c_str(), {pageX + pageW/2 + 12, ty + 24}, 12, 1, s.vnum); } DrawLineEx({pageX + 28, ty + 38}, {pageX + pageW - 28, ty + 38}, 1, {s.accent.r, s.accent.g, s.accent.b, 80}); ty += 52; }
+    if (!s.parallelMode) { for (size_t i = 0; i < pg.lines.size(); i++) { int vNum = pg.lineVerses[i]; int ci = pg.chapterBufIndex; if (ci >= 0 && ci < (int)s.view->buf.size()) { const auto& ch = *s.view->buf[ci];
+                if (!(s.studyMode && drawStudyPageLine(ch, pg.lines[i], vNum, pageX + 28, ty))) { for (const auto& m : s.searchResults) { if (m.bookIndex == ch.bookIndex && m.chapter == ch.chapter && m.verseNumber == vNum) { std::string matchStr = ToLower(s.searchBuf); std::string lineLower = ToLower(pg.lines[i]); size_t p = 0; while ((p = lineLower.find(matchStr, p)) != std::string::npos) { Vector2 pre = MeasureTextEx(f, pg.lines[i].substr(0, p).c_str(), s.fontSize, 1); Vector2 mid = MeasureTextEx(f, s.searchBuf, s.fontSize, 1); DrawRectangleRec({pageX + 28 + pre.x, ty, mid.x, s.fontSize + 2}, {220, 180, 60, 120}); p += matchStr.size(); } } } DrawTextEx(f, pg.lines[i].c_str(), {pageX + 28, ty}, s.fontSize, 1, s.text); } } ty += s.fontSize + s.lineSpacing; } }
+    else { float startTy = ty; for (size_t i = 0; i < pg.lines.size(); i++) { if (!(s.studyMode && pg.chapterBufIndex < (int)s.view->buf.size() && drawStudyPageLine(*s.view->buf[pg.chapterBufIndex], pg.lines[i], pg.lineVerses[i], pageX + 28, ty))) DrawTextEx(f, pg.lines[i].c_str(), {pageX + 28, ty}, s.fontSize, 1, s.text); ty += s.fontSize + s.lineSpacing; } ty = startTy; for (size_t i = 0; i < pg.lines2.size(); i++) { DrawTextEx(f, pg.lines2[i].c_str(), {pageX + pageW/2 + 12, ty}, s.fontSize, 1, s.text); ty += s.fontSize + s.lineSpacing; } }
     std::string pnum = "Page " + std::to_string(s.pageIdx + 1) + " / " + std::to_string(s.pages.size()); Vector2 pns = MeasureTextEx(f, pnum.c_str(), 13, 1); DrawTextEx(f, pnum.c_str(), {pageX + (pageW - pns.x) / 2.f, pageY + pageH - 22}, 13, 1, s.vnum);
     DrawTextEx(f, ("vv." + std::to_string(pg.startVerse) + "-" + std::to_string(pg.endVerse)).c_str(), {pageX + pageW - 88, pageY + 8}, 12, 1, s.vnum);
-    float ay = pageY + pageH / 2.f - 25; Rectangle prevBtn = {pageX - 60, ay, 40, 50}, nextBtn = {pageX + pageW + 20, ay, 40, 50}; bool prevHov = CheckCollisionPointRec(GetMousePosition(), prevBtn), nextHov = CheckCollisionPointRec(GetMousePosition(), nextBtn), atStart = (s.pageIdx == 0 && !s.buf.empty() && s.buf.front().bookIndex == 0 && s.buf.front().chapter == 1);
+    float ay = pageY + pageH / 2.f - 25; Rectangle prevBtn = {pageX - 60, ay, 40, 50}, nextBtn = {pageX + pageW + 20, ay, 40, 50}; bool prevHov = CheckCollisionPointRec(GetMousePosition(), prevBtn), nextHov = CheckCollisionPointRec(GetMousePosition(), nextBtn), atStart = (s.pageIdx == 0 && !s.view->buf.empty() && s.view->buf.front()->bookIndex == 0 && s.view->buf.front()->chapter == 1);
     if (!atStart) { DrawRectangleRec(prevBtn, prevHov ? s.accent : (Color){ s.hdr.r, s.hdr.g, s.hdr.b, 180 }); DrawRectangleLinesEx(prevBtn, 2, s.vnum); DrawTextEx(f, "<", {prevBtn.x + 13, prevBtn.y + 12}, 24, 1, prevHov ? RAYWHITE : s.text); if (prevHov && IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) s.BookPagePrev(f); }
     DrawRectangleRec(nextBtn, nextHov ? s.accent : (Color){ s.hdr.r, s.hdr.g, s.hdr.b, 180 }); DrawRectangleLinesEx(nextBtn, 2, s.vnum); DrawTextEx(f, ">", {nextBtn.x + 13, nextBtn.y + 12}, 24, 1, nextHov ? RAYWHITE : s.text); if (nextHov && IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) s.BookPageNext(f);
 }
@@ -459,8 +481,12 @@ void DrawFooter(AppState& s, Font f) {
     const float FH = 38; float fy = (float)GetScreenHeight() - FH; DrawRectangle(0, (int)fy, GetScreenWidth(), (int)FH, s.hdr); DrawLineEx({0, fy}, {(float)GetScreenWidth(), fy}, 1, s.vnum);
     if (s.isLoading) { float angle = (float)GetTime() * 300.0f; DrawPolyLinesEx({ (float)GetScreenWidth() - 30, fy + 19 }, 6, 10, angle, 2, s.accent); DrawTextEx(f, "Loading...", { (float)GetScreenWidth() - 110, fy + 10 }, 14, 1, s.accent); }
     DrawTextEx(f, "Divine Word v0.1", {18, fy + 10}, 14, 1, {s.vnum.r, s.vnum.g, s.vnum.b, 180});
-    if (!s.buf.empty()) { std::lock_guard<std::mutex> lock(s.bufferMutex); int ci = s.bookMode ? (s.pageIdx < (int)s.pages.size() ? s.pages[s.pageIdx].chapterBufIndex : 0) : s.scrollChapterIdx;
-        if (ci >= 0 && ci < (int)s.buf.size() && s.buf[ci].isLoaded) { std::string loc = s.buf[ci].book + " (" + s.buf[ci].translation + ")"; Vector2 locSz = MeasureTextEx(f, loc.c_str(), 14, 1); DrawTextEx(f, loc.c_str(), {((float)GetScreenWidth() - locSz.x)/2.0f, fy + 10}, 14, 1, s.vnum); } }
+    if (!s.view->buf.empty()) { int ci = s.bookMode ? (s.pageIdx < (int)s.pages.size() ? s.pages[s.pageIdx].chapterBufIndex : 0) : s.scrollChapterIdx;
+        if (ci >= 0 && ci < (int)s.view->buf.size() && s.view->buf[ci]->isLoaded) { std::string loc = s.view->buf[ci]->book + " (" + s.view->buf[ci]->translation + ")"; Vector2 locSz = MeasureTextEx(f, loc.c_str(), 14, 1); DrawTextEx(f, loc.c_str(), {((float)GetScreenWidth() - locSz.x)/2.0f, fy + 10}, 14, 1, s.vnum); } }
     if (s.statusTimer > 0) { Vector2 ss = MeasureTextEx(f, s.statusMsg.c_str(), 15, 1); DrawTextEx(f, s.statusMsg.c_str(), {((float)GetScreenWidth() - ss.x) / 2.f, fy + 10}, 15, 1, s.ok); }
-    const char* hint = s.bookMode ? "Arrow keys / < > = turn page" : "Scroll = infinite  |  Shift+Click = multi-select"; Vector2 hs = MeasureTextEx(f, hint, 12, 1); DrawTextEx(f, hint, {(float)GetScreenWidth() - hs.x - 16, fy + 12}, 12, 1, s.vnum);
+    if (g_transport->Offline()) { // Takes the hint's place: cache-only mode matters more than key help
+        const char* off = "Offline - saved chapters only"; Vector2 os = MeasureTextEx(f, off, 13, 1); float ox = (float)GetScreenWidth() - os.x - 16;
+        if (s.isLoading) ox -= 110; // Clear of the spinner
+        DrawCircle((int)(ox - 10), (int)(fy + 19), 4, s.err); DrawTextEx(f, off, {ox, fy + 12}, 13, 1, s.err);
+    } else { const char* hint = s.bookMode ? "Arrow keys / < > = turn page" : "Scroll = infinite  |  Shift+Click = multi-select"; Vector2 hs = MeasureTextEx(f, hint, 12, 1); DrawTextEx(f, hint, {(float)GetScreenWidth() - hs.x - 16, fy + 12}, 12, 1, s.vnum); }
 }
@@ -4,8 +4,8 @@
 #include <string>
 
 // --- Helper Functions ---
-std::vector<std::string> WrapText(const std::string& text, Font font, float fontSize, float maxWidth);
-std::vector<Page> BuildPages(const std::deque<Chapter>& chapters, const std::deque<Chapter>& chapters2, bool parallelMode, Font font, float pageW, float pageH, float fSize, float lSpacing);
+std::vector<std::string> WrapText(std::string_view text, Font font, float fontSize, float maxWidth);
+std::vector<Page> BuildPages(const std::deque<ChapterRef>& chapters, const std::deque<ChapterRef>& chapters2, bool parallelMode, Font font, float pageW, float pageH, float fSize, float lSpacing);
 
 inline void closeAllPanels(AppState& s) {
     s.showHistory = s.showFavorites = s.showCache = s.showPlan = s.showHelp = s.showSearch = s.showJump = s.showGlobalSearch = s.showNoteEditor = s.showBurgerMenu = s.showWordStudy = s.showAbout = false;
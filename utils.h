@@ -3,31 +3,29 @@
 #define RAYBIBLE_UTILS_H
 
 #include <string>
+#include <string_view>
 #include <vector>
+#include <ctime>
 
 // File System
 bool DirExists(const std::string& p);
 bool MakeDir(const std::string& p);
+bool RemoveDir(const std::string& p);
+bool RemoveTree(const std::string& p); // Recursive; a missing path counts as removed
 bool FileExists(const std::string& p);
 long GetFileSize(const std::string& p);
+time_t GetFileTime(const std::string& p); // Last modification; 0 if it cannot be read
 std::string ReadFile(const std::string& p);
 bool WriteFile(const std::string& p, const std::string& c);
+bool RenameFile(const std::string& from, const std::string& to); // Replaces `to` if it exists
+bool WriteFileAtomic(const std::string& p, const std::string& c, bool sync = false); // Write a temp file, then rename over p; `sync` waits for the disk first
+bool AppendFileSync(const std::string& p, const std::string& c); // Returns once the data is on disk; on failure the file is left as it was
 
 // Clipboard
 void CopyToClipboard(const std::string& text);
 
 // String helpers
-std::string ToLower(const std::string& s);
-std::string StripTags(const std::string& s);
+std::string ToLower(std::string_view s);
 std::string ReplaceAll(std::string str, const std::string& from, const std::string& to);
 
-// JSON Parser (simple)
-std::string JStr(const std::string& j, const std::string& k);
-int JInt(const std::string& j, const std::string& k);
-long JLong(const std::string& j, const std::string& k);
-std::vector<std::string> JArr(const std::string& j, const std::string& k);
-
-// HTTP Client
-std::string HttpGet(const std::string& url);
-
 #endif // UTILS_H
@@ -0,0 +1,91 @@
+#include "work_pool.h"
+#include <algorithm>
+
+WorkPool g_workPool;
+
+WorkPool::WorkPool(int threads) {
+    if (threads <= 0) threads = (int)std::thread::hardware_concurrency();
+    threads = std::max(threads, 1);
+    for (int i = 0; i < threads; i++) queues.push_back(std::make_unique<Queue>());
+}
+
+WorkPool::~WorkPool() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        quit = true;
+    }
+    wake.notify_all();
+    for (auto& t : workers) t.join();
+}
+
+bool WorkPool::Pop(int w, int& item) {
+    Queue& q = *queues[w];
+    std::lock_guard<std::mutex> lock(q.mtx);
+    if (q.items.empty()) return false;
+    item = q.items.front(); q.items.pop_front();
+    return true;
+}
+
+// From the back of the fullest queue: the victim keeps the items next to the one it is on
+bool WorkPool::Steal(int w, int& item) {
+    for (;;) {
+        int victim = -1; size_t most = 0;
+        for (int v = 0; v < Threads(); v++) {
+            if (v == w) continue;
+            std::lock_guard<std::mutex> lock(queues[v]->mtx);
+            if (queues[v]->items.size() > most) { most = queues[v]->items.size(); victim = v; }
+        }
+        if (victim < 0) return false;
+        std::lock_guard<std::mutex> lock(queues[victim]->mtx);
+        if (queues[victim]->items.empty()) continue; // Drained since we looked
+        item = queues[victim]->items.back(); queues[victim]->items.pop_back();
+        steals++;
+        return true;
+    }
+}
+
+void WorkPool::Run(Job& j, int w) {
+    int item;
+    while (Pop(w, item) || Steal(w, item)) {
+        if (!j.tok || !j.tok->Cancelled()) (*j.fn)(item, w);
+        if (--j.remaining == 0) { std::lock_guard<std::mutex> lock(mtx); idle.notify_all(); }
+    }
+}
+
+void WorkPool::ParallelFor(int n, const Item& fn, const CancelToken* tok) {
+    if (n <= 0) return;
+    std::lock_guard<std::mutex> jobLock(jobMtx);
+    int nq = Threads();
+    if (workers.empty()) for (int w = 0; w < nq - 1; w++) workers.emplace_back(&WorkPool::WorkerLoop, this, w);
+    Job j{&fn, tok, {n}};
+    for (int w = 0; w < nq; w++) {
+        std::lock_guard<std::mutex> lock(queues[w]->mtx);
+        for (int i = (int)((long)n * w / nq); i < (int)((long)n * (w + 1) / nq); i++) queues[w]->items.push_back(i);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        job = &j; generation++;
+    }
+    wake.notify_all();
+    Run(j, nq - 1);
+    std::unique_lock<std::mutex> lock(mtx);
+    idle.wait(lock, [&] { return j.remaining == 0 && busy == 0; });
+    job = nullptr; // A worker waking late now finds nothing to join
+}
+
+void WorkPool::WorkerLoop(int w) {
+    long seen = 0;
+    std::unique_lock<std::mutex> lock(mtx);
+    for (;;) {
+        wake.wait(lock, [&] { return quit || generation != seen; });
+        if (quit) break;
+        seen = generation;
+        if (!job) continue;
+        Job& j = *job;
+        busy++;
+        lock.unlock();
+        Run(j, w);
+        lock.lock();
+        if (--busy == 0) idle.notify_all();
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+#ifndef RAYBIBLE_WORK_POOL_H
+#define RAYBIBLE_WORK_POOL_H
+
+#include "task_scheduler.h"
+#include <functional>
+#include <memory>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+// Fork-join pool for bulk jobs made of many small independent items (a chapter each,
+// say). ParallelFor deals the items out in contiguous blocks, one deque per thread; a
+// thread works through its own block from the front and, once it runs dry, steals from
+// the back of the fullest other deque, so uneven items (Psalms next to Obadiah) still
+// keep every core busy. The calling thread takes part, and one job runs at a time.
+class WorkPool {
+public:
+    using Item = std::function<void(int item, int worker)>; // worker is in [0, Threads())
+
+    explicit WorkPool(int threads = 0); // 0: one per core
+    ~WorkPool();
+    int Threads() const { return (int)queues.size(); }
+    // Returns once every item has run, or been skipped because `tok` was cancelled
+    void ParallelFor(int n, const Item& fn, const CancelToken* tok = nullptr);
+    long Steals() const { return steals; }
+
+private:
+    struct Queue { std::mutex mtx; std::deque<int> items; };
+    struct Job { const Item* fn; const CancelToken* tok; std::atomic<int> remaining; };
+
+    std::vector<std::unique_ptr<Queue>> queues; // Last one belongs to the calling thread
+    std::vector<std::thread> workers;           // Started by the first job
+    std::mutex jobMtx;                          // One ParallelFor at a time
+    std::mutex mtx;
+    std::condition_variable wake, idle;
+    Job* job = nullptr;
+    long generation = 0;
+    int busy = 0; // Workers inside the current job; it may not end while any still are
+    bool quit = false;
+    std::atomic<long> steals{0};
+
+    bool Pop(int w, int& item);
+    bool Steal(int w, int& item);
+    void Run(Job& j, int w);
+    void WorkerLoop(int w);
+};
+
+extern WorkPool g_workPool;
+
+#endif // RAYBIBLE_WORK_POOL_H